@@ -0,0 +1,157 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file measures the building of the graph of a synthetic
+/*  skeleton, a cubic lattice of lines, and the stack it uses.
+/*
+/**********************************************************************/
+
+#include "trabecula/tubular_object.hpp"
+#include "trabecula/swap.hpp"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+
+using namespace Trabecula;
+
+/***********************************************  UTILITIES  declaration  ***************************************************/
+
+// value of the unused bytes of the stack of the graph thread
+static const unsigned char STACK_FILL = 0xA5;
+
+static int write_lattice(const std::string& filename, int nodes, int spacing);
+static void* build_graph(void* object);
+
+/******************************************************************************************
+* Graph_bench : the lattice has 'nodes' junctions along each axis, 'spacing' voxels apart,
+* so 3 * nodes^2 * (nodes - 1) edges (about 10^6 by default). Its graph is built on a
+* thread whose stack is allocated here and filled with a known value: the bytes changed
+* after the build give the stack used.
+******************************************************************************************/
+int main(int argc, char *argv[])
+{
+    const int nodes = argc > 1 ? std::max(atoi(argv[1]), 2) : 70;
+    const int spacing = argc > 2 ? std::max(atoi(argv[2]), 4) : 6;
+    const std::size_t stack_size = (std::size_t)(argc > 3 ? std::max(atoi(argv[3]), 64) : 256) << 10;
+
+    const std::string filename = "graph_bench_lattice";
+    if(write_lattice(filename, nodes, spacing))
+    {
+        std::cerr << "Lattice write failed!" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Tubular_object object;
+    if(object.load_from_file(filename))
+    {
+        return EXIT_FAILURE;
+    }
+    object.skeletonize();
+
+    void* stack;
+    if(posix_memalign(&stack, 4096, stack_size))
+    {
+        return EXIT_FAILURE;
+    }
+    memset(stack, STACK_FILL, stack_size);
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstack(&attributes, stack, stack_size);
+
+    pthread_t thread;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if(pthread_create(&thread, &attributes, build_graph, &object))
+    {
+        std::cerr << "Graph thread creation failed!" << std::endl;
+        return EXIT_FAILURE;
+    }
+    pthread_join(thread, 0);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    pthread_attr_destroy(&attributes);
+
+    // the stack grows down from its end.
+    std::size_t unused = 0;
+    while (unused < stack_size && ((const unsigned char*)stack)[unused] == STACK_FILL)
+    {
+        ++unused;
+    }
+    free(stack);
+
+    std::cout << object.graph().edge_count() << " edges, " << object.graph().node_count() << " nodes (lattice of "
+              << 3L * nodes * nodes * (nodes - 1) << " edges): " << seconds << "s, "
+              << object.graph().edge_count() / seconds << " edges/s, " << (stack_size - unused) / 1024.0
+              << " KiB of stack used out of " << (stack_size >> 10) << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+/***********************************************  UTILITIES  definition  ****************************************************/
+/*******************************************************************************
+*   write_lattice : write an Analyze image of the lines along x, y and z
+*                   joining the junctions of the lattice, shifted by spacing
+*                   along x. The graph starts on an end point, so the first
+*                   line along x starts at x = 0 as a branch.
+*******************************************************************************/
+static int write_lattice(const std::string& filename, int nodes, int spacing)
+{
+    const int size = (nodes - 1) * spacing + 1;
+    const int size_x = size + spacing;
+
+    ANALYZE_DSR dsr;
+    memset(&dsr, 0, sizeof(dsr));
+    dsr.hk.sizeof_hdr = 348;
+    dsr.hk.regular = 'r';
+    dsr.dime.dim[0] = 4;
+    dsr.dime.dim[1] = size_x;
+    dsr.dime.dim[2] = dsr.dime.dim[3] = size;
+    dsr.dime.dim[4] = 1;
+    dsr.dime.datatype = ANALYZE_DT_UNSIGNED_CHAR;
+    dsr.dime.bitpix = 8;
+    dsr.dime.pixdim[1] = dsr.dime.pixdim[2] = dsr.dime.pixdim[3] = 0.01;
+    dsr.little = little_endian();
+
+    std::vector<char> image((std::size_t)size_x * size * size, 0);
+    for (int x = 0; x < spacing; ++x)
+    {
+        image[x] = 1;
+    }
+    for (int z = 0; z < size; ++z)
+    {
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                // on a line when at least 2 coordinates are on the lattice.
+                const int on_lattice = (x % spacing == 0) + (y % spacing == 0) + (z % spacing == 0);
+                image[((std::size_t)z * size + y) * size_x + spacing + x] = on_lattice >= 2;
+            }
+        }
+    }
+
+    if(anaWriteHeader((filename + ".hdr").c_str(), &dsr))
+    {
+        return 1;
+    }
+    return anaWriteImagedata((filename + ".img").c_str(), &dsr, &image[0]);
+}
+
+/*******************************************************************************
+*   build_graph : body of the graph thread.
+*******************************************************************************/
+static void* build_graph(void* object)
+{
+    static_cast<Tubular_object*>(object)->build_graph();
+    return 0;
+}
@@ -0,0 +1,164 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file compares the simple point tests on the neighbourhoods
+/*  met while thinning an Analyze image.
+/*
+/**********************************************************************/
+
+#include "trabecula/tubular_object.hpp"
+#include "trabecula/simple_tests.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Trabecula;
+
+/***********************************************  UTILITIES  declaration  ***************************************************/
+
+static void collect_border_masks(const std::vector<unsigned char>& image, const Sizes& sizes,
+                                 std::vector<unsigned int>& masks);
+
+template <class Simple_test>
+static void time_test(const char* name, const Simple_test& simple_test, const std::vector<unsigned int>& masks,
+                      int repetitions, const std::vector<unsigned char>& image, const Sizes& sizes,
+                      const std::vector<unsigned char>& skeleton);
+
+/******************************************************************************************
+* Simple_test_bench : the neighbourhood masks of the border points of the image before
+* each iteration of the sequential thinning are the configurations the thinning meets.
+* Each test is timed on all of them, then on a whole thinning, whose skeleton must be the
+* one of the table.
+******************************************************************************************/
+int main(int argc, char *argv[])
+{
+    if(argc < 2)
+    {
+        std::cout << "usage: filename without extension [repetitions]" << std::endl;
+        return 0;
+    }
+
+    const int repetitions = argc > 2 ? std::max(atoi(argv[2]), 1) : 1;
+
+    Tubular_object object;
+    if(object.load_from_file(argv[1]))
+    {
+        return EXIT_FAILURE;
+    }
+
+    const Sizes& sizes = object.sizes();
+    std::vector<unsigned char> image(sizes.size_enlarged);
+    object.data().unpack(&image[0]);
+
+    /* the configurations met by the thinning, and its skeleton */
+    std::vector<unsigned int> masks;
+    std::vector<unsigned char> skeleton(image);
+    Thinning thinning(&skeleton[0], sizes);
+    thinning.seed_all();
+    do
+    {
+        collect_border_masks(skeleton, sizes, masks);
+
+    } while(thinning.iterate() > 0);
+
+    std::cout << masks.size() << " configurations" << std::endl;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const Euler_simple_test euler;
+    std::cout << "euler table built in "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    const Decision_tree_simple_test tree;
+    std::cout << "decision tree built in "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s, "
+              << tree.nodes() << " nodes, " << tree.leaves() << " leaves" << std::endl;
+
+    time_test("table", Simple_point_table::instance(), masks, repetitions, image, sizes, skeleton);
+    time_test("recursive", Recursive_simple_test(), masks, repetitions, image, sizes, skeleton);
+    time_test("euler", euler, masks, repetitions, image, sizes, skeleton);
+    time_test("tree", tree, masks, repetitions, image, sizes, skeleton);
+
+    return EXIT_SUCCESS;
+}
+
+/***********************************************  UTILITIES  definition  ****************************************************/
+/*******************************************************************************
+*   collect_border_masks : add the neighbourhood masks of the black points
+*                          with a white 6-neighbour to masks.
+*******************************************************************************/
+static void collect_border_masks(const std::vector<unsigned char>& image, const Sizes& sizes,
+                                 std::vector<unsigned int>& masks)
+{
+    Neighbourhood_scanner scanner(&image[0], sizes);
+    unsigned int mask;
+
+    for (int i = 0; i < (int)sizes.size_enlarged; ++i)
+    {
+        if (image[i])
+        {
+            mask = scanner.mask(i);
+            if ((mask & N6_MASK) != N6_MASK)
+            {
+                masks.push_back(mask);
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+*   time_test : print the time per test on the masks (the best of the
+*               repetitions), its disagreements with the table, and the time
+*               of a sequential thinning of the image with the test.
+*******************************************************************************/
+template <class Simple_test>
+static void time_test(const char* name, const Simple_test& simple_test, const std::vector<unsigned int>& masks,
+                      int repetitions, const std::vector<unsigned char>& image, const Sizes& sizes,
+                      const std::vector<unsigned char>& skeleton)
+{
+    const Simple_point_table& table = Simple_point_table::instance();
+    double best = 0.0;
+    std::size_t simple = 0;
+
+    for (int r = 0; r < repetitions; ++r)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        simple = 0;
+        for (std::size_t i = 0; i < masks.size(); ++i)
+        {
+            simple += simple_test.is_simple(masks[i]);
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        best = r == 0 ? seconds : std::min(best, seconds);
+    }
+
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < masks.size(); ++i)
+    {
+        mismatches += simple_test.is_simple(masks[i]) != table.is_simple(masks[i]);
+    }
+
+    std::vector<unsigned char> thinned(image);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Thinning thinning(&thinned[0], sizes);
+    thinning.seed_all();
+    thinning.run(simple_test);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::setw(10) << name << ": " << std::fixed << std::setprecision(2)
+              << best * 1e9 / std::max<std::size_t>(masks.size(), 1) << " ns per test, " << simple << " simple, "
+              << mismatches << " mismatches, thinning " << std::setprecision(3) << seconds << "s"
+              << (thinned == skeleton ? "" : " (different skeleton!)") << std::endl;
+}
@@ -0,0 +1,376 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file compares the thinning modes on an Analyze image: their
+/*  time, and the size and topology of their skeletons.
+/*
+/**********************************************************************/
+
+#include "trabecula/tubular_object.hpp"
+#include "trabecula/topology.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace Trabecula;
+
+// thresholds of the clean-up of the image, as in main
+static const int MIN_COMPONENT_VOXELS = 10;
+static const int MAX_CAVITY_VOXELS = 10;
+
+/***********************************************  UTILITIES  declaration  ***************************************************/
+
+static int object_components(const std::vector<unsigned char>& image, const Sizes& sizes);
+static int background_components(const std::vector<unsigned char>& image, const Sizes& sizes);
+static void count_points(const std::vector<unsigned char>& image, const Sizes& sizes,
+                         int& points, int& end_points, int& deletable_points);
+static int open_cache_counter(bool last_level);
+static long long read_counter(int counter);
+
+/******************************************************************************************
+* Thinning_bench : thin the image with each mode, and print the time of the thinning, the
+* points, end points and still deletable points (simple and non end) of the skeleton, and
+* its numbers of 26-connected components and of 6-connected background components, which
+* must be the ones of the image. Then the time of the sequential thinning with the mask
+* cache, the conflicts met by the speculative mode, and the cache misses per checked
+* point of the sequential thinning in raster order, in Morton order and on bricks (from
+* the hardware counters, when the system gives them). Last, the time of the thinning and
+* of the graph of the image without its small islands, with and without its small
+* cavities filled.
+******************************************************************************************/
+int main(int argc, char *argv[])
+{
+    if(argc < 2)
+    {
+        std::cout << "usage: filename without extension [threads] [repetitions]" << std::endl;
+        return 0;
+    }
+
+    const unsigned int threads = argc > 2 ? atoi(argv[2]) : 0;
+    const int repetitions = argc > 3 ? std::max(atoi(argv[3]), 1) : 1;
+
+    Tubular_object object;
+    if(object.load_from_file(argv[1]))
+    {
+        return EXIT_FAILURE;
+    }
+
+    const Sizes& sizes = object.sizes();
+    std::vector<unsigned char> image(sizes.size_enlarged);
+    object.data().unpack(&image[0]);
+
+    std::cout << "image: " << object_components(image, sizes) << " components, "
+              << background_components(image, sizes) << " background components" << std::endl;
+
+    static const char* NAMES[5] = { "sequential", "subfield", "parallel", "ordered", "speculative" };
+    static const Thinning_mode MODES[5] = { SEQUENTIAL_THINNING, SUBFIELD_THINNING, PARALLEL_THINNING,
+                                            ORDERED_THINNING, SPECULATIVE_THINNING };
+
+    std::vector<unsigned char> skeleton(sizes.size_enlarged);
+    for (int m = 0; m < 5; ++m)
+    {
+        double best = 0.0;
+        for (int r = 0; r < repetitions; ++r)
+        {
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            skeletonize_data(&image[0], &skeleton[0], sizes, MODES[m], threads);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            best = r == 0 ? seconds : std::min(best, seconds);
+        }
+
+        int points, end_points, deletable_points;
+        count_points(skeleton, sizes, points, end_points, deletable_points);
+
+        std::cout << std::setw(11) << NAMES[m] << ": " << std::fixed << std::setprecision(3) << best << "s, "
+                  << points << " points, " << end_points << " end points, " << deletable_points << " deletable, "
+                  << object_components(skeleton, sizes) << " components, "
+                  << background_components(skeleton, sizes) << " background components" << std::endl;
+    }
+
+    /* sequential thinning with and without the mask cache */
+    for (int cache = 0; cache < 2; ++cache)
+    {
+        std::vector<unsigned char> thinned(image);
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Thinning thinning(&thinned[0], sizes);
+        thinning.set_mask_cache(cache);
+        thinning.seed_all();
+        thinning.run();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        skeletonize_data(&image[0], &skeleton[0], sizes);
+        std::cout << (cache ? "cached masks: " : "recomputed masks: ") << seconds << "s, "
+                  << thinning.counters().checks << " checks" << (thinned == skeleton ? "" : " (different skeleton!)")
+                  << std::endl;
+    }
+
+    /* conflicts of the speculative mode */
+    std::vector<unsigned char> thinned(image);
+    Thread_pool pool(threads);
+    Thinning thinning(&thinned[0], sizes);
+    thinning.seed_all();
+    thinning.run_speculative(pool);
+
+    const Thinning_counters& counters = thinning.counters();
+    std::cout << "speculative: " << counters.speculative_deletions << " parallel deletions, "
+              << counters.conflicts << " conflicts ("
+              << 100.0 * counters.conflicts / std::max(counters.speculative_deletions + counters.conflicts, 1ul)
+              << "%), " << counters.serial_deletions << " serial deletions" << std::endl;
+
+    /* cache misses of the candidate orders */
+    static const char* ORDERS[3] = { "raster", "morton", "bricks" };
+    const int l1_counter = open_cache_counter(false);
+    const int llc_counter = open_cache_counter(true);
+
+    for (int o = 0; o < 3; ++o)
+    {
+        thinned = image;
+        Brick_volume* bricks = o == 2 ? new Brick_volume(&image[0], sizes) : 0;
+        Thinning* ordered_thinning = bricks ? new Thinning(*bricks) : new Thinning(&thinned[0], sizes);
+        ordered_thinning->set_candidate_order(o == 1 ? MORTON_ORDER : RASTER_ORDER);
+
+        const long long l1_start = read_counter(l1_counter);
+        const long long llc_start = read_counter(llc_counter);
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ordered_thinning->seed_all();
+        ordered_thinning->run();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const long long l1_misses = read_counter(l1_counter) - l1_start;
+        const long long llc_misses = read_counter(llc_counter) - llc_start;
+
+        if (bricks)
+        {
+            bricks->to_flat(&thinned[0]);
+            delete bricks;
+        }
+
+        const unsigned long checks = ordered_thinning->counters().checks;
+        delete ordered_thinning;
+
+        std::cout << std::setw(6) << ORDERS[o] << " order: " << seconds << "s, " << checks << " checks, ";
+        if (l1_counter >= 0 && llc_counter >= 0)
+        {
+            std::cout << (double)l1_misses / std::max(checks, 1ul) << " L1 misses and "
+                      << (double)llc_misses / std::max(checks, 1ul) << " LLC misses per check, ";
+        }
+        else
+        {
+            std::cout << "no hardware counters, ";
+        }
+        std::cout << object_components(thinned, sizes) << " components, "
+                  << background_components(thinned, sizes) << " background components" << std::endl;
+    }
+
+    /* thinning and graph with and without the small cavities */
+    for (int fill = 0; fill < 2; ++fill)
+    {
+        Tubular_object cleaned;
+        cleaned.load_from_file(argv[1]);
+        const int removed = cleaned.remove_small_components(MIN_COMPONENT_VOXELS, threads);
+        const int filled = fill ? cleaned.fill_cavities(MAX_CAVITY_VOXELS, threads) : 0;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        cleaned.skeletonize(SEQUENTIAL_THINNING, threads);
+        const double thinning_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        cleaned.build_graph();
+        const double graph_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << removed << " islands removed, " << filled << " cavities filled: thinning " << thinning_seconds
+                  << "s, " << cleaned.skeleton_data().count() << " skeleton points, graph " << graph_seconds << "s, "
+                  << cleaned.graph().node_count() << " nodes, " << cleaned.graph().edge_count() << " edges" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/***********************************************  UTILITIES  definition  ****************************************************/
+/*******************************************************************************
+*   object_components : number of 26-connected components of the black points.
+*******************************************************************************/
+static int object_components(const std::vector<unsigned char>& image, const Sizes& sizes)
+{
+    std::vector<bool> visited(sizes.size_enlarged, false);
+    std::vector<int> stack;
+    int offsets[26];
+    collect_26_neighbours(0, sizes, offsets);
+    int components = 0;
+
+    for (int i = 0; i < sizes.size_enlarged; ++i)
+    {
+        if (!image[i] || visited[i])
+        {
+            continue;
+        }
+
+        ++components;
+        visited[i] = true;
+        stack.push_back(i);
+        while (!stack.empty())
+        {
+            const int p = stack.back();
+            stack.pop_back();
+
+            // black points are never on the zero borders.
+            for (int n = 0; n < 26; ++n)
+            {
+                const int q = p + offsets[n];
+                if (image[q] && !visited[q])
+                {
+                    visited[q] = true;
+                    stack.push_back(q);
+                }
+            }
+        }
+    }
+
+    return components;
+}
+
+/*******************************************************************************
+*   background_components : number of 6-connected components of the white
+*                           points, the zero borders included.
+*******************************************************************************/
+static int background_components(const std::vector<unsigned char>& image, const Sizes& sizes)
+{
+    const int size_x = sizes.size_x_enlarged;
+    const int size_y = sizes.size_y_enlarged;
+    const int size_z = sizes.size_z_enlarged;
+    const int layer = sizes.xOy_enlarged_size;
+    std::vector<bool> visited(sizes.size_enlarged, false);
+    std::vector<int> stack;
+    int components = 0;
+
+    for (int i = 0; i < sizes.size_enlarged; ++i)
+    {
+        if (image[i] || visited[i])
+        {
+            continue;
+        }
+
+        ++components;
+        visited[i] = true;
+        stack.push_back(i);
+        while (!stack.empty())
+        {
+            const int p = stack.back();
+            stack.pop_back();
+
+            const int x = p % size_x;
+            const int y = (p / size_x) % size_y;
+            const int z = p / layer;
+            const int neighbours[6] = { x > 0 ? p - 1 : -1, x + 1 < size_x ? p + 1 : -1,
+                                        y > 0 ? p - size_x : -1, y + 1 < size_y ? p + size_x : -1,
+                                        z > 0 ? p - layer : -1, z + 1 < size_z ? p + layer : -1 };
+
+            for (int n = 0; n < 6; ++n)
+            {
+                const int q = neighbours[n];
+                if (q >= 0 && !image[q] && !visited[q])
+                {
+                    visited[q] = true;
+                    stack.push_back(q);
+                }
+            }
+        }
+    }
+
+    return components;
+}
+
+/*******************************************************************************
+*   count_points : numbers of black points, of end points, and of simple non
+*                  end points with a white 6-neighbour.
+*******************************************************************************/
+static void count_points(const std::vector<unsigned char>& image, const Sizes& sizes,
+                         int& points, int& end_points, int& deletable_points)
+{
+    const Simple_point_table& simple_points = Simple_point_table::instance();
+    Neighbourhood_scanner scanner(&image[0], sizes);
+    unsigned int mask;
+
+    points = end_points = deletable_points = 0;
+    for (int i = 0; i < sizes.size_enlarged; ++i)
+    {
+        if (!image[i])
+        {
+            continue;
+        }
+
+        mask = scanner.mask(i);
+        ++points;
+        if (count_neighbours(mask) == 1)
+        {
+            ++end_points;
+        }
+        else if ((mask & 0x3F) != 0x3F && count_neighbours(mask) > 1 && simple_points.is_simple(mask))
+        {
+            ++deletable_points;
+        }
+    }
+}
+
+/*******************************************************************************
+*   open_cache_counter : open and start a counter of the L1 data cache read
+*                        misses, or of the last level cache misses, of this
+*                        thread. Return -1 when there is none.
+*******************************************************************************/
+static int open_cache_counter(bool last_level)
+{
+#ifdef __linux__
+    perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    if (last_level)
+    {
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+    }
+    else
+    {
+        attributes.type = PERF_TYPE_HW_CACHE;
+        attributes.config = PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                            PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+    }
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+
+    return syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+/*******************************************************************************
+*   read_counter : Return the value of a counter, or 0 when it is not open.
+*******************************************************************************/
+static long long read_counter(int counter)
+{
+    long long value = 0;
+#ifdef __linux__
+    if (counter >= 0 && read(counter, &value, sizeof(value)) != sizeof(value))
+    {
+        value = 0;
+    }
+#endif
+    return value;
+}
@@ -112,9 +112,11 @@ typedef struct
 /*****************************************************************************/
 int anaReadHeader(const char *filename, ANALYZE_DSR *h);
 int anaReadImagedata(const char *filename, const ANALYZE_DSR *h, int frame, char *data);
+int anaReadBinaryslices(const char *filename, const ANALYZE_DSR *h, int first_slice, int nb_slices, char *data);
 /*****************************************************************************/
 int anaWriteHeader(const char *filename, const ANALYZE_DSR *h);
 int anaWriteImagedata(const char *filename, const ANALYZE_DSR *h, const char *data);
+int anaWriteImageslices(const char *filename, const ANALYZE_DSR *h, int first_slice, int nb_slices, const char *data);
 /*****************************************************************************/
 int anaPrintHeader(const ANALYZE_DSR *h, FILE *fp);
 /*****************************************************************************/
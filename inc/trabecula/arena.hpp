@@ -0,0 +1,134 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace Trabecula
+{
+
+/********************************************************/
+/* Arena is a monotonic allocator: allocate() takes the */
+/* next bytes of its current block, or of a new one,    */
+/* and nothing is freed until reset(), which frees all  */
+/* at once. The blocks are kept for the next use, so    */
+/* a second pass of similar size allocates nothing.     */
+/* The objects of an arena are not destroyed: they must */
+/* own no other memory than the one of the arena.       */
+/********************************************************/
+class Arena
+{
+
+public:
+	/* Constructors/Destructors */
+    explicit Arena(std::size_t block_size = 1 << 16);
+    ~Arena();
+
+public:
+	/* Getters */
+    /* bytes of the blocks */
+    std::size_t capacity() const;
+
+public:
+	/* Member Functions */
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        char* p = mNext + (-(std::size_t)mNext & (alignment - 1));
+        if (p + bytes > mEnd)
+        {
+            return allocate_block(bytes, alignment);
+        }
+        mNext = p + bytes;
+        return p;
+    }
+
+    void reset();
+
+private:
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+
+    void* allocate_block(std::size_t bytes, std::size_t alignment);
+
+private:
+	/* Member Variables */
+	std::size_t mBlockSize;
+
+	std::vector<char*> mBlocks;
+	std::vector<std::size_t> mBlockSizes;
+
+	/* current block, and its free bytes */
+	std::size_t mBlock;
+	char* mNext;
+	char* mEnd;
+};
+
+/********************************************************/
+/* Arena_allocator lets the standard containers take    */
+/* their memory from an Arena. deallocate() does        */
+/* nothing: the memory comes back on reset().           */
+/********************************************************/
+template <class T>
+class Arena_allocator
+{
+
+public:
+    typedef T value_type;
+
+	/* Constructors/Destructors */
+    explicit Arena_allocator(Arena& arena) : mArena(&arena)
+    {
+    }
+
+    template <class U>
+    Arena_allocator(const Arena_allocator<U>& other) : mArena(other.arena())
+    {
+    }
+
+public:
+	/* Getters */
+    Arena* arena() const
+    {
+        return mArena;
+    }
+
+public:
+	/* Member Functions */
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(mArena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t)
+    {
+    }
+
+private:
+	/* Member Variables */
+	Arena* mArena;
+};
+
+template <class T, class U>
+bool operator==(const Arena_allocator<T>& a, const Arena_allocator<U>& b)
+{
+    return a.arena() == b.arena();
+}
+
+template <class T, class U>
+bool operator!=(const Arena_allocator<T>& a, const Arena_allocator<U>& b)
+{
+    return a.arena() != b.arena();
+}
+
+} // end of namespace Trabecula
+
+#endif // ARENA_HPP
@@ -0,0 +1,84 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef BIT_VOLUME_HPP
+#define BIT_VOLUME_HPP
+
+namespace Trabecula
+{
+
+/********************************************************/
+/* Bit_volume stores a binary image with one bit per    */
+/* voxel, packed in 64-bit words (bit p & 63 of the     */
+/* word p >> 6). Bulk operations work a word at a time. */
+/********************************************************/
+class Bit_volume
+{
+
+public:
+	/* Constructors/Destructors */
+    Bit_volume();
+    explicit Bit_volume(unsigned int size);
+    ~Bit_volume();
+
+public:
+	/* Getters */
+    unsigned int size() const;
+    unsigned int word_count() const;
+    bool empty() const;
+    unsigned long long* words();
+    const unsigned long long* words() const;
+
+    bool test(unsigned int p) const
+    {
+        return (mWords[p >> 6] >> (p & 63)) & 1;
+    }
+
+public:
+	/* Setters */
+    void set(unsigned int p)
+    {
+        mWords[p >> 6] |= 1ull << (p & 63);
+    }
+
+    void reset(unsigned int p)
+    {
+        mWords[p >> 6] &= ~(1ull << (p & 63));
+    }
+
+public:
+	/* Member Functions */
+    /* reallocate for size voxels, all cleared */
+    void resize(unsigned int size);
+    void clear();
+
+    /* number of set voxels */
+    unsigned int count() const;
+
+    /* first set voxel from p, or size() */
+    unsigned int next(unsigned int p) const;
+
+    /* conversions from/to one byte per voxel (non zero bytes are set) */
+    void pack(const unsigned char* bytes);
+    void unpack(unsigned char* bytes) const;
+
+private:
+    Bit_volume(const Bit_volume&);
+    Bit_volume& operator=(const Bit_volume&);
+
+private:
+	/* Member Variables */
+	unsigned long long* mWords;
+	unsigned int mSize;
+	unsigned int mWordCount;
+};
+
+} // end of namespace Trabecula
+
+#endif // BIT_VOLUME_HPP
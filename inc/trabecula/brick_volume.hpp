@@ -0,0 +1,91 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef BRICK_VOLUME_HPP
+#define BRICK_VOLUME_HPP
+
+#include "trabecula/sizes.hpp"
+
+namespace Trabecula
+{
+
+/* FLAT_LAYOUT stores the voxels x-fastest, BRICK_LAYOUT in 8x8x8 bricks */
+enum Volume_layout
+{
+    FLAT_LAYOUT,
+    BRICK_LAYOUT
+};
+
+static const int BRICK_SIZE = 8;
+static const int BRICK_VOXELS = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+
+/********************************************************/
+/* Brick_volume stores a zero-bordered binary image in  */
+/* 8x8x8 bricks of 512 contiguous bytes, so that the    */
+/* 26-neighbourhood of a voxel lies in one or a few     */
+/* bricks instead of 3 slices of the image.             */
+/* The voxels are addressed by storage indices. Since   */
+/* every brick has the same shape, the offset to a      */
+/* neighbour only depends on the position of the voxel  */
+/* on the faces of its brick (27 cases), and is read    */
+/* from a precomputed table.                            */
+/********************************************************/
+class Brick_volume
+{
+
+public:
+	/* Constructors/Destructors */
+    Brick_volume(const unsigned char* data, const Sizes& sizes);
+    ~Brick_volume();
+
+public:
+	/* Getters */
+    unsigned char* data();
+    const unsigned char* data() const;
+    const Sizes& sizes() const;
+    int size() const;
+
+public:
+	/* Member Functions */
+    /* storage indice of the flat (enlarged) indice p */
+    int storage(int p) const;
+
+    /* storage indice of the neighbour n (ordered as in collect_26_neighbours) of s */
+    int neighbour(int s, int n) const
+    {
+        return s + mOffsets[mCases[s & (BRICK_VOXELS - 1)]][n];
+    }
+
+    /* neighbourhood mask of the voxel s */
+    unsigned int mask(int s) const;
+
+    /* copy the voxels into a flat (enlarged) image */
+    void to_flat(unsigned char* flat) const;
+
+private:
+    Brick_volume(const Brick_volume&);
+    Brick_volume& operator=(const Brick_volume&);
+
+private:
+	/* Member Variables */
+	unsigned char* mData;
+	Sizes mSizes;
+
+	/* number of bricks along x, y, z, and number of voxels */
+	int mBricks[3];
+	int mSize;
+
+	/* face case of each voxel of a brick, and neighbour offsets of each case */
+	unsigned char mCases[BRICK_VOXELS];
+	int mOffsets[27][26];
+};
+
+} // end of namespace Trabecula
+
+#endif // BRICK_VOLUME_HPP
@@ -0,0 +1,43 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef COMPONENTS_HPP
+#define COMPONENTS_HPP
+
+#include "trabecula/sizes.hpp"
+#include "trabecula/thread_pool.hpp"
+
+#include <vector>
+
+namespace Trabecula
+{
+
+/* Number of voxels of a 26-connected component, and its first voxel in raster order */
+struct Component_stats
+{
+    int voxels;
+    int first;
+};
+
+/* Label the 26-connected components of the black points of a zero-bordered binary     */
+/* image (enlarged sizes): labels[p] is 0 on a white point, else the label of the      */
+/* component of p, from 1 in the raster order of the first voxels, whatever the number */
+/* of threads. The stats of the label l are components[l - 1]. Return the number of    */
+/* components.                                                                          */
+int label_components(const unsigned char* data, const Sizes& sizes, unsigned int* labels,
+                     std::vector<Component_stats>& components, Thread_pool& pool);
+
+/* Same for the 6-connected components of the white points. The first one contains the */
+/* zero borders: the other ones are the cavities of the image.                          */
+int label_background_components(const unsigned char* data, const Sizes& sizes, unsigned int* labels,
+                                std::vector<Component_stats>& components, Thread_pool& pool);
+
+} // end of namespace Trabecula
+
+#endif // COMPONENTS_HPP
@@ -0,0 +1,27 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef DISTANCE_TRANSFORM_HPP
+#define DISTANCE_TRANSFORM_HPP
+
+#include "trabecula/sizes.hpp"
+#include "trabecula/thread_pool.hpp"
+
+namespace Trabecula
+{
+
+/* Compute the squared euclidean distance of every point of a zero-bordered binary */
+/* image (enlarged sizes) to the nearest white point, white points being at 0.     */
+/* The distances are exact, computed on the pool one x, y, then z line at a time.  */
+void squared_distance_transform(const unsigned char* data, const Sizes& sizes, unsigned int* distances,
+                                Thread_pool& pool);
+
+} // end of namespace Trabecula
+
+#endif // DISTANCE_TRANSFORM_HPP
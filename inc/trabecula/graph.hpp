@@ -0,0 +1,150 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef GRAPH_HPP
+#define GRAPH_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace Trabecula
+{
+
+/* Contiguous run of voxel indices, or of node or edge ids, of a Graph */
+struct Index_range
+{
+    const int* first;
+    const int* last;
+
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+    std::size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    int front() const { return *first; }
+    int back() const { return *(last - 1); }
+    int operator[](std::size_t i) const { return first[i]; }
+};
+
+/********************************************************/
+/* Graph of the skeleton, as flat arrays: the nodes and */
+/* edges are numbered from 0, the voxels of all nodes   */
+/* (and of all edges) are concatenated, with the offset */
+/* of node n at n and of its end at n + 1, and the      */
+/* edges of each node are stored the same way (CSR).    */
+/* The edge voxels are in order from front to back.     */
+/* It is filled by add_node(), add_edge() and connect() */
+/* then build_adjacency().                              */
+/********************************************************/
+class Graph
+{
+
+public:
+	/* Constructors/Destructors */
+    Graph();
+
+public:
+	/* Getters */
+    int node_count() const
+    {
+        return (int)mConnectivities.size();
+    }
+
+    int edge_count() const
+    {
+        return (int)mLengths.size();
+    }
+
+    int connectivity(int n) const
+    {
+        return mConnectivities[n];
+    }
+
+    Index_range node_voxels(int n) const
+    {
+        Index_range range = { mNodeVoxels.data() + mNodeOffsets[n], mNodeVoxels.data() + mNodeOffsets[n + 1] };
+        return range;
+    }
+
+    Index_range node_edges(int n) const
+    {
+        Index_range range = { mAdjacency.data() + mAdjacencyOffsets[n], mAdjacency.data() + mAdjacencyOffsets[n + 1] };
+        return range;
+    }
+
+    float length(int e) const
+    {
+        return mLengths[e];
+    }
+
+    Index_range edge_voxels(int e) const
+    {
+        Index_range range = { mEdgeVoxels.data() + mEdgeOffsets[e], mEdgeVoxels.data() + mEdgeOffsets[e + 1] };
+        return range;
+    }
+
+    /* first (end 0) or second (end 1) node of an edge, or -1 */
+    int edge_node(int e, int end) const
+    {
+        return mEdgeNodes[2 * e + end];
+    }
+
+    /* per node and per edge values, for the measures */
+    const std::vector<int>& connectivities() const;
+    const std::vector<float>& lengths() const;
+
+public:
+	/* Member Functions */
+    void clear();
+
+    /* Return the id of a new node or edge, of the voxels [first, last) */
+    template <class Iterator>
+    int add_node(Iterator first, Iterator last, int connectivity)
+    {
+        mConnectivities.push_back(connectivity);
+        mNodeVoxels.insert(mNodeVoxels.end(), first, last);
+        mNodeOffsets.push_back(mNodeVoxels.size());
+
+        return (int)mConnectivities.size() - 1;
+    }
+
+    template <class Iterator>
+    int add_edge(Iterator first, Iterator last, float length)
+    {
+        mLengths.push_back(length);
+        mEdgeVoxels.insert(mEdgeVoxels.end(), first, last);
+        mEdgeOffsets.push_back(mEdgeVoxels.size());
+        mEdgeNodes.push_back(-1);
+        mEdgeNodes.push_back(-1);
+
+        return (int)mLengths.size() - 1;
+    }
+
+    /* attach a node to an end of an edge, the first one if free */
+    void connect(int node, int edge);
+
+    /* fill the edges of each node from the nodes of the edges */
+    void build_adjacency();
+
+private:
+	/* Member Variables */
+	std::vector<int> mConnectivities;
+	std::vector<int> mNodeOffsets;
+	std::vector<int> mNodeVoxels;
+	std::vector<int> mAdjacencyOffsets;
+	std::vector<int> mAdjacency;
+
+	std::vector<float> mLengths;
+	std::vector<int> mEdgeOffsets;
+	std::vector<int> mEdgeVoxels;
+	std::vector<int> mEdgeNodes;
+};
+
+} // end of namespace Trabecula
+
+#endif // GRAPH_HPP
@@ -0,0 +1,109 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef GRAPH_LABELS_HPP
+#define GRAPH_LABELS_HPP
+
+#include "trabecula/sizes.hpp"
+#include "trabecula/arena.hpp"
+
+#include <vector>
+
+namespace Trabecula
+{
+
+class Node;
+class Edge;
+
+/********************************************************/
+/* Graph_labels tags each voxel of a zero-bordered      */
+/* image with the node or edge of the graph it belongs  */
+/* to, as a 32-bit label: 0 off the graph, e > 0 on the */
+/* edge e, -n < 0 on the node n. The labels are given   */
+/* by add_edge() and add_node() in order of creation,   */
+/* and a removed label is not given again.              */
+/* That is 4 bytes per voxel, instead of the 16 of a    */
+/* pair of Node and Edge pointers.                      */
+/* The nodes and edges, and their voxels, live in the   */
+/* Arena of the labels: clear() frees them at once.     */
+/********************************************************/
+class Graph_labels
+{
+
+public:
+	/* Constructors/Destructors */
+    explicit Graph_labels(const Sizes& sizes);
+
+public:
+	/* Getters */
+    int label(int p) const
+    {
+        return mLabels[p];
+    }
+
+    /* node or edge of the voxel p, or 0 */
+    Node* node_at(int p) const
+    {
+        return mLabels[p] < 0 ? mNodes[-mLabels[p] - 1] : 0;
+    }
+
+    Edge* edge_at(int p) const
+    {
+        return mLabels[p] > 0 ? mEdges[mLabels[p] - 1] : 0;
+    }
+
+    /* node or edge of a label */
+    Node* node(int label) const
+    {
+        return mNodes[-label - 1];
+    }
+
+    Edge* edge(int label) const
+    {
+        return mEdges[label - 1];
+    }
+
+    /* number of node labels given, removed ones included */
+    int node_count() const
+    {
+        return (int)mNodes.size();
+    }
+
+public:
+	/* Setters */
+    void set(int p, int label)
+    {
+        mLabels[p] = label;
+    }
+
+public:
+	/* Member Functions */
+    /* Return the label of a new empty node or edge */
+    int add_node();
+    int add_edge();
+
+    /* forget a label, once its voxels are relabelled */
+    void remove(int label);
+
+    /* clear the labels of the voxels of the nodes and edges, and free them */
+    void clear();
+
+private:
+	/* Member Variables */
+	std::vector<int> mLabels;
+
+	Arena mArena;
+
+	std::vector<Node*> mNodes;
+	std::vector<Edge*> mEdges;
+};
+
+} // end of namespace Trabecula
+
+#endif // GRAPH_LABELS_HPP
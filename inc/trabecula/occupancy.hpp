@@ -0,0 +1,96 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef OCCUPANCY_HPP
+#define OCCUPANCY_HPP
+
+#include "trabecula/sizes.hpp"
+#include "trabecula/bit_volume.hpp"
+#include "trabecula/brick_volume.hpp"
+
+#include <vector>
+
+namespace Trabecula
+{
+
+/********************************************************/
+/* Occupancy keeps, for a flat zero-bordered image, the */
+/* number of black voxels of each block of             */
+/* BRICK_SIZE^3 voxels, and a bit per non empty block.  */
+/* It is updated point by point as voxels are added or  */
+/* deleted (a block may also be left marked after its   */
+/* voxels are deleted elsewhere: the marks only have to */
+/* cover the black voxels).                             */
+/* next() visits the voxels of the marked blocks in     */
+/* raster order, skipping the empty blocks of a row and */
+/* the empty rows of blocks:                            */
+/*   for (i = occupancy.next(0); i < size;              */
+/*        i = occupancy.next(i + 1))                    */
+/* next() remembers the last run of marked blocks it    */
+/* found on a row, so that it only looks for the next   */
+/* one at the end of the run: an Occupancy is not to be */
+/* iterated by several threads at once.                 */
+/********************************************************/
+class Occupancy
+{
+
+public:
+	/* Constructors/Destructors */
+    explicit Occupancy(const Sizes& sizes);
+
+public:
+	/* Getters */
+    bool occupied(int p) const
+    {
+        return mOccupied.test(block(p));
+    }
+
+public:
+	/* Member Functions */
+    /* mark the blocks of the black voxels of an image */
+    void build(const unsigned char* data);
+    void build(const Bit_volume& data);
+
+    void add(int p);
+    void remove(int p);
+
+    /* first voxel from p in a marked block, or size_enlarged */
+    unsigned int next(unsigned int p) const
+    {
+        if (p >= mRunFirst && p < mRunLast)
+        {
+            return p;
+        }
+        return next_run(p);
+    }
+
+private:
+    unsigned int next_run(unsigned int p) const;
+    int block(int p) const;
+
+private:
+	/* Member Variables */
+	const Sizes& mSizes;
+
+	/* number of blocks along x, y, z */
+	int mBlocksX;
+	int mBlocksY;
+	int mBlocksZ;
+
+	std::vector<unsigned short> mCounts;
+	Bit_volume mOccupied;
+
+	/* last run of voxels of marked blocks found on a row */
+	mutable unsigned int mRunFirst;
+	mutable unsigned int mRunLast;
+};
+
+} // end of namespace Trabecula
+
+#endif // OCCUPANCY_HPP
@@ -0,0 +1,74 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef ORDERED_THINNING_HPP
+#define ORDERED_THINNING_HPP
+
+#include "trabecula/sizes.hpp"
+#include "trabecula/thread_pool.hpp"
+#include "trabecula/bit_volume.hpp"
+
+#include <vector>
+
+namespace Trabecula
+{
+
+/********************************************************/
+/* Ordered_thinning thins a zero-bordered binary image  */
+/* (flat layout) in place, in the order of the distance */
+/* of its points to the background: the points are      */
+/* popped from a bucket queue of squared distances, and */
+/* a popped point is deleted when it is a simple non    */
+/* end border point. Otherwise it waits, until the      */
+/* deletion of one of its neighbours puts it back in    */
+/* the current bucket. Every point is popped once, plus */
+/* once per deletion around it.                         */
+/* The squared distances stay available after run().    */
+/* As in Thinning, the first and last z-layers are      */
+/* never deleted.                                       */
+/********************************************************/
+class Ordered_thinning
+{
+
+public:
+	/* Constructors/Destructors */
+    Ordered_thinning(unsigned char* data, const Sizes& sizes);
+
+public:
+	/* Getters */
+    const std::vector<unsigned int>& distances() const;
+
+public:
+	/* Member Functions */
+    int run(Thread_pool& pool);
+
+private:
+    void erase(int p, std::vector<int>& bucket);
+
+private:
+	/* Member Variables */
+	unsigned char* mData;
+	const Sizes& mSizes;
+
+	/* the points that may be deleted are in [mFirst, mLast) */
+	int mFirst;
+	int mLast;
+
+	/* flat offsets of the 26 neighbours */
+	int mOffsets[26];
+
+	/* squared distances to the background, the bucket queue, and the waiting points */
+	std::vector<unsigned int> mDistances;
+	std::vector<std::vector<int> > mBuckets;
+	Bit_volume mWaiting;
+};
+
+} // end of namespace Trabecula
+
+#endif // ORDERED_THINNING_HPP
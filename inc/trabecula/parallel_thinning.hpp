@@ -0,0 +1,83 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef PARALLEL_THINNING_HPP
+#define PARALLEL_THINNING_HPP
+
+#include "trabecula/sizes.hpp"
+#include "trabecula/thread_pool.hpp"
+#include "trabecula/bit_volume.hpp"
+
+#include <vector>
+
+namespace Trabecula
+{
+
+/********************************************************/
+/* Parallel_thinning thins a zero-bordered binary image */
+/* (flat layout) in place, by 12 directional            */
+/* subiterations, in the order of the 12-subiteration   */
+/* algorithm of Palagyi and Kuba: the candidates of a   */
+/* subiteration are the border points of one of a pair  */
+/* of directions (US, NE, DW, ...).                     */
+/* Every point of a subiteration is decided from the    */
+/* image left by the previous one: a simple non end     */
+/* candidate is deleted when it stays simple and non    */
+/* end whatever candidates among its neighbours that    */
+/* precede it in raster order are deleted. Deleting the */
+/* points in raster order would then only delete simple */
+/* points, so the topology is preserved, and the result */
+/* does not depend on the number of threads.            */
+/* As in Thinning, the first and last z-layers are      */
+/* never deleted.                                       */
+/********************************************************/
+class Parallel_thinning
+{
+
+public:
+	/* Constructors/Destructors */
+    Parallel_thinning(unsigned char* data, const Sizes& sizes);
+
+public:
+	/* Member Functions */
+    void seed_all();
+    int run(Thread_pool& pool);
+    int iterate(Thread_pool& pool);
+
+private:
+    int subiter(int subiteration, Thread_pool& pool);
+    bool is_deletable(unsigned int mask, unsigned int preceding) const;
+    void erase(int p);
+
+private:
+	/* Member Variables */
+	unsigned char* mData;
+	const Sizes& mSizes;
+
+	/* the points that may be deleted are in [mFirst, mLast) */
+	int mFirst;
+	int mLast;
+
+	/* flat offsets of the 26 neighbours, and mask of the ones preceding a point */
+	int mOffsets[26];
+	unsigned int mPreceding;
+
+	/* black points with a white 6-neighbour, and their marks */
+	std::vector<int> mSurface;
+	Bit_volume mOnSurface;
+
+	/* candidates of the subiteration, and points to delete, of each task */
+	std::vector<std::vector<int> > mCandidates;
+	std::vector<std::vector<int> > mDeletable;
+	Bit_volume mIsCandidate;
+};
+
+} // end of namespace Trabecula
+
+#endif // PARALLEL_THINNING_HPP
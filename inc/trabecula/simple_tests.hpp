@@ -0,0 +1,128 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef SIMPLE_TESTS_HPP
+#define SIMPLE_TESTS_HPP
+
+#include "trabecula/topology.hpp"
+
+#include <vector>
+
+namespace Trabecula
+{
+
+/* A simple point test is a class with a member bool is_simple(unsigned int mask) const, */
+/* answering as Simple_point_table for every neighbourhood mask: the central point is a  */
+/* border point (a white 6-neighbour), and deleting it keeps the topology. The thinning  */
+/* loops take it as a template parameter (see Thinning::run).                            */
+/* Simple_point_table is the lookup table one, the default of the thinning.              */
+
+/********************************************************/
+/* Recursive_simple_test unpacks the mask and runs the  */
+/* recursive reference test (is_simple of topology).    */
+/********************************************************/
+class Recursive_simple_test
+{
+
+public:
+	/* Member Functions */
+    bool is_simple(unsigned int mask) const
+    {
+        if ((mask & N6_MASK) == N6_MASK || !mask)
+        {
+            return false;
+        }
+
+        int np[26];
+        neighbourhood_values(mask, np);
+        return Trabecula::is_simple(np);
+    }
+};
+
+/********************************************************/
+/* Euler_simple_test checks that deleting the point     */
+/* keeps the Euler characteristic, summed over the 8    */
+/* octants of the neighbourhood from a 128 entry table, */
+/* and that its black neighbours are 26-connected, by   */
+/* the flood fill of is_26_connected. (Lee, Kashyap and */
+/* Chu, Building skeleton models via 3-D medial         */
+/* surface/axis thinning algorithms, 1994)              */
+/********************************************************/
+class Euler_simple_test
+{
+
+public:
+	/* Constructors/Destructors */
+    Euler_simple_test();
+
+public:
+	/* Member Functions */
+    bool is_simple(unsigned int mask) const;
+
+private:
+	/* Member Variables */
+	/* 8 times the change of the Euler characteristic in an octant, by its 7 other points */
+	int mEuler[128];
+
+	/* neighbours of the central point in each octant, by the bits of mEuler */
+	int mOctants[8][7];
+};
+
+/********************************************************/
+/* Decision_tree_simple_test walks a reduced ordered    */
+/* binary decision diagram of Simple_point_table: each  */
+/* node tests one of the neighbours 25 down to 6, and   */
+/* the leaves are 64 bit words indexed by the 6-        */
+/* adjacent ones. The nodes whose two children are the  */
+/* same are skipped, and equal subtrees are shared.     */
+/********************************************************/
+class Decision_tree_simple_test
+{
+
+public:
+	/* Constructors/Destructors */
+    Decision_tree_simple_test();
+
+public:
+	/* Getters */
+    std::size_t nodes() const;
+    std::size_t leaves() const;
+
+public:
+	/* Member Functions */
+    bool is_simple(unsigned int mask) const
+    {
+        int node = mRoot;
+        while (node >= 0)
+        {
+            const Node& n = mNodes[node];
+            node = (mask >> n.bit) & 1 ? n.high : n.low;
+        }
+        return (mLeaves[~node] >> (mask & N6_MASK)) & 1;
+    }
+
+private:
+    /* a child is a node index, or the complement of a leaf index */
+    struct Node
+    {
+        int bit;
+        int low;
+        int high;
+    };
+
+private:
+	/* Member Variables */
+	std::vector<Node> mNodes;
+	std::vector<unsigned long long> mLeaves;
+	int mRoot;
+};
+
+} // end of namespace Trabecula
+
+#endif // SIMPLE_TESTS_HPP
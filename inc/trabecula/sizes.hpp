@@ -0,0 +1,34 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef SIZES_HPP
+#define SIZES_HPP
+
+namespace Trabecula
+{
+
+/* Struct storing 3D dimensions and the enlarged dimensions */
+/*	when images are zero-bordered                           */
+struct Sizes
+{
+	unsigned int size_x;
+	unsigned int size_y;
+	unsigned int size_z;
+	unsigned int size_x_enlarged;
+	unsigned int size_y_enlarged;
+	unsigned int size_z_enlarged;
+	unsigned int size;
+	unsigned int size_enlarged;
+	unsigned int xOy_size;
+	unsigned int xOy_enlarged_size;
+};
+
+} // end of namespace Trabecula
+
+#endif // SIZES_HPP
@@ -0,0 +1,30 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef SLAB_THINNING_HPP
+#define SLAB_THINNING_HPP
+
+#include "trabecula/thinning.hpp"
+
+#include <string>
+#include <cstddef>
+
+namespace Trabecula
+{
+
+/* Compute the skeleton of the Analyze image filename(.hdr/.img) into                  */
+/* <name>_skeleton(.hdr/.img), without loading the whole image: the skeleton file is   */
+/* thinned in place, one z-slab at a time. The slabs are as thick as memory_budget     */
+/* (in bytes) allows for a slab and its thinning.                                      */
+int skeletonize_file(const std::string& filename, std::size_t memory_budget,
+                     Thinning_mode mode = SEQUENTIAL_THINNING, unsigned int threads = 0);
+
+} // end of namespace Trabecula
+
+#endif // SLAB_THINNING_HPP
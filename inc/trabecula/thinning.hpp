@@ -0,0 +1,252 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef THINNING_HPP
+#define THINNING_HPP
+
+#include "trabecula/sizes.hpp"
+#include "trabecula/thread_pool.hpp"
+#include "trabecula/brick_volume.hpp"
+#include "trabecula/bit_volume.hpp"
+#include "trabecula/topology.hpp"
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+namespace Trabecula
+{
+
+/* SEQUENTIAL_THINNING deletes the points one at a time, in raster order.   */
+/* SUBFIELD_THINNING deletes the points of each of the 8 parity classes of   */
+/* the grid in parallel. Its skeleton differs from the sequential one, but   */
+/* does not depend on the number of threads.                                 */
+/* PARALLEL_THINNING deletes the points of each of 12 directional            */
+/* subiterations in parallel (see Parallel_thinning), on the flat layout     */
+/* whatever the layout asked.                                                */
+/* ORDERED_THINNING deletes the points in the order of their distance to the */
+/* background (see Ordered_thinning), on the flat layout too.                */
+/* SPECULATIVE_THINNING deletes the points of a subiteration by chunks in    */
+/* parallel, rolling back the deletions that conflict (see Thinning). Its    */
+/* skeleton may depend on the scheduling of the threads.                     */
+enum Thinning_mode
+{
+    SEQUENTIAL_THINNING,
+    SUBFIELD_THINNING,
+    PARALLEL_THINNING,
+    ORDERED_THINNING,
+    SPECULATIVE_THINNING
+};
+
+/* RASTER_ORDER visits the candidates of the sequential subiterations in the */
+/* order of their indices: raster order on the flat layout, brick order on  */
+/* bricks. MORTON_ORDER visits them in the Z-order of their coordinates on  */
+/* the flat layout, so that consecutive candidates are close along the 3    */
+/* axes and their neighbourhoods share cache lines. Its skeleton differs    */
+/* from the raster one, as the brick order does.                            */
+enum Candidate_order
+{
+    RASTER_ORDER,
+    MORTON_ORDER
+};
+
+/* Compute the skeleton of a zero-bordered binary image (data and skeleton may be the same) */
+/* 0 threads means one per hardware thread                                                  */
+int skeletonize_data(const unsigned char* data, unsigned char* skeleton, const Sizes& sizes,
+                     Thinning_mode mode = SEQUENTIAL_THINNING, unsigned int threads = 0,
+                     Volume_layout layout = FLAT_LAYOUT);
+int skeletonize_data(const Bit_volume& data, Bit_volume& skeleton, const Sizes& sizes,
+                     Thinning_mode mode = SEQUENTIAL_THINNING, unsigned int threads = 0,
+                     Volume_layout layout = FLAT_LAYOUT);
+
+/* Thin again in place a skeleton (a zero-bordered binary image that the thinning   */
+/* leaves unchanged) from which the removed points were just deleted. The result is */
+/* the one of skeletonize_data in the sequential mode, in time proportional to the  */
+/* points around the removed ones.                                                  */
+void rethin_data(unsigned char* skeleton, const Sizes& sizes, const std::vector<int>& removed,
+                 Volume_layout layout = FLAT_LAYOUT);
+
+/* Work of the deletion passes of the sequential subiterations: the points */
+/* checked, and the ones a full rescan of the candidates would also have   */
+/* checked although none of their neighbours changed. For the speculative  */
+/* subiterations: the points deleted by the threads, the deletions rolled  */
+/* back or skipped for a conflict with another thread, and the points      */
+/* deleted by the serial passes that resolve the conflicts.                */
+struct Thinning_counters
+{
+    unsigned long checks;
+    unsigned long avoided_checks;
+    unsigned long speculative_deletions;
+    unsigned long conflicts;
+    unsigned long serial_deletions;
+};
+
+/********************************************************/
+/* Thinning implements the sequential 3D thinning of    */
+/* "A sequential 3D thinning algorithm and its medical  */
+/* applications (2001)" on a binary image, in place.    */
+/* Instead of rescanning every black point, it keeps    */
+/* for each of the 6 directions the sorted array of the */
+/* current border points, and only adds the neighbours  */
+/* of the deleted points: the work of an iteration is   */
+/* proportional to the surface, not to the volume.      */
+/* run_subfields() deletes the border points of one     */
+/* parity class at once: two points of the same class   */
+/* are never 26-adjacent, so each one is tested on a    */
+/* neighbourhood the others do not change.              */
+/* run_speculative() deletes the border points of a     */
+/* direction by chunks in parallel, each thread in the  */
+/* sequential order: a point is marked as being deleted */
+/* before its neighbourhood is read again, so of two    */
+/* neighbours deleted at once, one thread at least sees */
+/* the mark of the other and restores its point. The    */
+/* passes go on until they delete nothing, the last one */
+/* serial when only conflicts remain.                   */
+/* With set_mask_cache(true), the sequential passes     */
+/* keep the mask of each candidate, and a deletion      */
+/* clears its bit in the masks of its candidate         */
+/* neighbours: checking a point again reads nothing.    */
+/* On a Brick_volume, the points are storage indices    */
+/* and the sequential order is the brick order.         */
+/* set_candidate_order(MORTON_ORDER) sorts the border   */
+/* arrays by Morton code instead, on the flat layout;   */
+/* the deletion passes then find a point of the list by */
+/* its code.                                            */
+/* seed_around() starts from the points around changed */
+/* ones instead: the border arrays then also take every */
+/* black neighbour of a deleted point, which may become */
+/* deletable.                                           */
+/* On the flat layout, the first and last z-layers are  */
+/* never deleted: they are the zero borders of an image */
+/* or the halo layers of a slab.                        */
+/********************************************************/
+class Thinning
+{
+
+public:
+	/* Constructors/Destructors */
+    Thinning(unsigned char* data, const Sizes& sizes);
+    Thinning(Brick_volume& bricks);
+
+public:
+	/* Setters */
+    void set_mask_cache(bool enabled);
+    void set_candidate_order(Candidate_order order);
+
+public:
+	/* Getters */
+    const Thinning_counters& counters() const;
+
+public:
+	/* Member Functions */
+    void seed_all();
+    void seed_around(const std::vector<int>& changed);
+    int run();
+    int run_subfields(Thread_pool& pool);
+    int iterate();
+    int iterate_subfields(Thread_pool& pool);
+    int run_speculative(Thread_pool& pool);
+    int iterate_speculative(Thread_pool& pool);
+
+    /* sequential thinning with another simple point test (see simple_tests.hpp), */
+    /* instantiated for the tests of simple_tests.hpp and Simple_point_table      */
+    template <class Simple_test> int run(const Simple_test& simple_test);
+    template <class Simple_test> int iterate(const Simple_test& simple_test);
+
+private:
+    /* kernels for the strides of the image (Runtime_strides on bricks) */
+    template <class Strides, class Simple_test> int iterate_with(const Simple_test& simple_test);
+    template <class Strides> int iterate_subfields_with(Thread_pool& pool);
+    template <class Strides, class Simple_test> int subiter(int direction, const Simple_test& simple_test);
+    template <class Strides> int subfield_subiter(int direction, Thread_pool& pool);
+    int speculative_subiter(int direction, Thread_pool& pool);
+    unsigned int speculative_mask(int p, bool& conflict) const;
+    int parity(int p) const;
+    void set_directions();
+
+    /* neighbour of p in a direction, and neighbourhood mask of p */
+    int neighbour(int p, int direction) const
+    {
+        return mBricks ? mBricks->neighbour(p, DIRECTION_NEIGHBOURS[direction]) : p + mDirections[direction];
+    }
+
+    /* neighbour n (ordered as in collect_26_neighbours) of p */
+    int neighbour_26(int p, int n) const
+    {
+        return mBricks ? mBricks->neighbour(p, n) : p + mOffsets[n];
+    }
+
+    template <class Scanner>
+    unsigned int mask(Scanner& scanner, int p) const
+    {
+        return mBricks ? mBricks->mask(p) : scanner.mask(p);
+    }
+
+    /* neighbour index of each direction, as in collect_26_neighbours */
+    static const int DIRECTION_NEIGHBOURS[6];
+    void sort_borders(int direction);
+    void push_borders(int p);
+    void queue_neighbours(const std::vector<int>& list, int i, unsigned int mask, bool first_pass);
+    void uncache_neighbours(const std::vector<int>& list, int i, unsigned int mask);
+    int list_index(const std::vector<int>& list, int i, int q) const;
+    bool follows(const std::vector<int>& list, int i, int q) const;
+    unsigned long long morton_key(int p) const;
+    void erase(int p);
+
+private:
+	/* Member Variables */
+	unsigned char* mData;
+	const Sizes& mSizes;
+	const Brick_volume* mBricks;
+	int mSize;
+
+	/* the points that may be deleted are in [mFirst, mLast) */
+	int mFirst;
+	int mLast;
+
+	/* Up, Down, North, South, East, West : opposite directions are d and d ^ 1 */
+	int mDirections[6];
+
+	/* flat offsets of the 26 neighbours, and mask of the ones that may precede a point */
+	int mOffsets[26];
+	unsigned int mPreceding;
+
+	/* the black neighbours of the deleted points are pushed, as by seed_around */
+	bool mLocal;
+
+	/* border points of each direction, sorted in the candidate order up to mSorted, */
+	/* and the Morton codes of the sorted ones                                       */
+	Candidate_order mOrder;
+	std::vector<int> mBorders[6];
+	std::size_t mSorted[6];
+	std::vector<unsigned long long> mBorderKeys[6];
+	std::vector<std::pair<unsigned long long, int> > mSortKeys;
+
+	/* border points of each subfield, and points to delete of each task */
+	std::vector<int> mSubfields[8];
+	std::vector<std::vector<int> > mDeletable;
+
+	/* deletion passes of subiter : candidates, queued ones and their marks */
+	std::vector<int> mList;
+	std::vector<unsigned long long> mListKeys;
+	Bit_volume mListed;
+	std::vector<int> mQueued;
+	std::vector<int> mLate;
+	std::vector<int> mNext;
+	std::vector<unsigned char> mMarks;
+	Thinning_counters mCounters;
+
+	/* neighbourhood masks of the candidates, when cached */
+	bool mCacheMasks;
+	std::vector<unsigned int> mMasks;
+};
+
+} // end of namespace Trabecula
+
+#endif // THINNING_HPP
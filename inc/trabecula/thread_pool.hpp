@@ -0,0 +1,71 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+namespace Trabecula
+{
+
+/********************************************************/
+/* Thread_pool keeps a set of worker threads alive, so  */
+/* that the many short parallel loops of the thinning   */
+/* do not pay for the creation of threads. The calling  */
+/* thread takes part in the work of run().              */
+/********************************************************/
+class Thread_pool
+{
+
+public:
+	/* Constructors/Destructors */
+    /* 0 threads means one per hardware thread */
+    explicit Thread_pool(unsigned int threads = 0);
+    ~Thread_pool();
+
+public:
+	/* Getters */
+    unsigned int size() const;
+
+public:
+	/* Member Functions */
+    /* call task(i) for each i in [0, tasks), and wait for all of them */
+    void run(int tasks, const std::function<void(int)>& task);
+
+private:
+    Thread_pool(const Thread_pool&);
+    Thread_pool& operator=(const Thread_pool&);
+
+    void work();
+    void execute();
+
+private:
+	/* Member Variables */
+	std::vector<std::thread> mThreads;
+	std::mutex mMutex;
+	std::condition_variable mStart;
+	std::condition_variable mDone;
+
+	const std::function<void(int)>* mTask;
+	int mTasks;
+	std::atomic<int> mNext;
+	unsigned int mBusy;
+	unsigned long mGeneration;
+	bool mStop;
+};
+
+} // end of namespace Trabecula
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,286 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+
+#ifndef TOPOLOGY_HPP
+#define TOPOLOGY_HPP
+
+#include "trabecula/sizes.hpp"
+
+namespace Trabecula
+{
+
+/* A 26-neighbourhood is packed into the 26 low bits of an unsigned int, */
+/* bit i being set when the neighbour i is black. The neighbours are     */
+/* ordered as in collect_26_neighbours : 6-adjacent ones in bits 0-5,    */
+/* 18-adjacent ones in bits 6-17 and 26-adjacent ones in bits 18-25.     */
+static const unsigned int NEIGHBOURHOOD_SIZE = 1u << 26;
+static const unsigned int N6_MASK = 0x3Fu;
+
+/********************************************************/
+/* Strides of a flat zero-bordered image, from its      */
+/* Sizes (Runtime_strides), or fixed at compile time    */
+/* for the common image sizes (Fixed_strides), so that  */
+/* the neighbour offsets fold into the addressing of    */
+/* the loads.                                           */
+/********************************************************/
+class Runtime_strides
+{
+
+public:
+	/* Constructors/Destructors */
+    explicit Runtime_strides(const Sizes& sizes) : mVertical(sizes.size_x_enlarged), mDepth(sizes.xOy_enlarged_size)
+    {
+    }
+
+public:
+	/* Getters */
+    int vertical() const { return mVertical; }
+    int depth() const { return mDepth; }
+
+private:
+	/* Member Variables */
+	int mVertical;
+	int mDepth;
+};
+
+template <int SIZE_X_ENLARGED, int SIZE_Y_ENLARGED>
+class Fixed_strides
+{
+
+public:
+	/* Constructors/Destructors */
+    explicit Fixed_strides(const Sizes&)
+    {
+    }
+
+public:
+	/* Getters */
+    int vertical() const { return SIZE_X_ENLARGED; }
+    int depth() const { return SIZE_X_ENLARGED * SIZE_Y_ENLARGED; }
+
+    static bool matches(const Sizes& sizes)
+    {
+        return sizes.size_x_enlarged == SIZE_X_ENLARGED && sizes.size_y_enlarged == SIZE_Y_ENLARGED;
+    }
+};
+
+/* strides of the 256^3, 512^3 and 1024^3 images, with their zero borders */
+typedef Fixed_strides<258, 258> Strides_256;
+typedef Fixed_strides<514, 514> Strides_512;
+typedef Fixed_strides<1026, 1026> Strides_1024;
+
+/* indices of the 26 neighbours of p (offsets when p is 0) */
+template <class Strides>
+inline void collect_26_neighbours(int p, const Strides& strides, int np[26])
+{
+    /*  west : p - 1
+        east : p + 1
+        north : p + width*height
+        south : p - width*height
+        up : p - width
+        down : p + width
+    */
+    const int vertical = strides.vertical();
+    const int depth = strides.depth();
+
+    /* 6-adjacent */
+    np[0] = p - vertical;                //    U
+    np[1] = p + depth;                   //     N
+    np[2] = p - 1;                       // W
+    np[3] = p + 1;                       // E
+    np[4] = p - depth;                   //     S
+    np[5] = p + vertical;                //   D
+
+    /* 18-adjacent */
+    np[6] = p - vertical + depth;        //   U N
+    np[7] = p - 1 - vertical;            // W U
+    np[8] = p + 1 - vertical;            // E U
+    np[9] = p - vertical - depth;        //   U S
+    np[10] = p - 1  + depth;             // W   N
+    np[11] = p + 1 + depth;              // E   N
+    np[12] = p - 1 - depth;              // W   S
+    np[13] = p + 1 - depth;              // E   S
+    np[14] = p + vertical + depth;       //   D N
+    np[15] = p - 1 + vertical;           // W D
+    np[16] = p + 1 + vertical;           // E D
+    np[17] = p + vertical - depth;       //   D S
+
+    /* 26-adjacent */
+    np[18] = p - 1 - vertical + depth;   // W U N
+    np[19] = p + 1 - vertical + depth;   // E U N
+    np[20] = p - 1 - vertical - depth;   // W U S
+    np[21] = p + 1 - vertical - depth;   // E U S
+    np[22] = p - 1 + vertical + depth;   // W D N
+    np[23] = p + 1 + vertical + depth;   // E D N
+    np[24] = p - 1 + vertical - depth;   // W D S
+    np[25] = p + 1 + vertical - depth;   // E D S
+}
+
+inline void collect_26_neighbours(int p, const Sizes& sizes, int np[26])
+{
+    collect_26_neighbours(p, Runtime_strides(sizes), np);
+}
+
+/* x, y, z offsets (-1, 0 or 1) of the neighbour n */
+void neighbour_delta(int n, int delta[3]);
+
+/* neighbourhood mask of 26 binary values (0 or 1) */
+unsigned int neighbourhood_mask(const int np[26]);
+
+/* 26 binary values (0 or 1) of a neighbourhood mask */
+void neighbourhood_values(unsigned int mask, int np[26]);
+
+/* number of black neighbours, and index of the first one, of a mask */
+inline int count_neighbours(unsigned int mask)
+{
+    return __builtin_popcount(mask);
+}
+
+inline int first_neighbour(unsigned int mask)
+{
+    return __builtin_ctz(mask);
+}
+
+/* number of black neighbours of every point of a binary (0 or 1) zero-bordered image, */
+/* as a 3x3x3 box sum minus the point. Only the points off the borders are counted.    */
+void neighbour_counts(const unsigned char* data, const Sizes& sizes, unsigned char* counts);
+
+/* Reference (recursive) implementation of the simple point test */
+bool is_simple(const int np[26]);
+bool is_cond_2_satisfied(const int np[26]);
+bool is_cond_4_satisfied(const int np[26]);
+
+/* Non recursive tests on a neighbourhood mask, used to build the table */
+bool is_simple_mask(unsigned int mask);
+bool is_26_connected(unsigned int mask);
+
+/* compare the table against the reference test on 'samples' configurations */
+bool check_simple_point_table(unsigned int samples);
+
+/********************************************************/
+/* Simple_point_table stores one bit per configuration  */
+/* of the 26-neighbourhood (8 MiB) telling if the       */
+/* central point is simple. The table is built once per */
+/* process, the first time it is requested.             */
+/********************************************************/
+class Simple_point_table
+{
+
+public:
+	/* Constructors/Destructors */
+    ~Simple_point_table();
+
+public:
+	/* Getters */
+    static const Simple_point_table& instance();
+
+    bool is_simple(unsigned int mask) const
+    {
+        return (mBits[mask >> 6] >> (mask & 63)) & 1;
+    }
+
+private:
+	/* Constructors/Destructors */
+    Simple_point_table();
+    Simple_point_table(const Simple_point_table&);
+    Simple_point_table& operator=(const Simple_point_table&);
+
+private:
+	/* Member Variables */
+	unsigned long long* mBits;
+};
+
+/* neighbourhood masks of the voxels found in each z-layer (9 bits) of a 3x3x3 cube, */
+/* whose voxels are at the bits x + 3*y + 9*z                                       */
+extern unsigned int LAYER_MASKS[3][512];
+
+inline unsigned int mask_from_cube(unsigned int cube)
+{
+    return LAYER_MASKS[0][cube & 511] | LAYER_MASKS[1][(cube >> 9) & 511] | LAYER_MASKS[2][cube >> 18];
+}
+
+/********************************************************/
+/* Neighbourhood_scanner computes the 26-neighbourhood  */
+/* masks of the voxels of a binary image. Consecutive   */
+/* voxels of a x-row share two of their 3x3 columns, so */
+/* sliding along a row only loads the 9 new voxels.     */
+/* reset() must be called when the image is modified.   */
+/* Basic_neighbourhood_scanner takes the strides of the */
+/* image as a parameter.                                */
+/********************************************************/
+template <class Strides>
+class Basic_neighbourhood_scanner
+{
+
+public:
+	/* Constructors/Destructors */
+    Basic_neighbourhood_scanner(const unsigned char* data, const Sizes& sizes) :
+        mData(data), mStrides(sizes), mLast(-2), mCube(0)
+    {
+    }
+
+public:
+	/* Member Functions */
+    /* When p follows the previous point on its row, the cube is shifted by */
+    /* one column to the west and only the eastern column is loaded.        */
+    unsigned int mask(int p)
+    {
+        static const unsigned int CUBE_X2 = 0x4924924;   // x == 2
+
+        if (p == mLast + 1)
+        {
+            mCube = ((mCube >> 1) & ~CUBE_X2) | (column(p + 1) << 2);
+        }
+        else
+        {
+            mCube = column(p - 1) | (column(p) << 1) | (column(p + 1) << 2);
+        }
+        mLast = p;
+
+        return mask_from_cube(mCube);
+    }
+
+    void reset()
+    {
+        mLast = -2;
+    }
+
+private:
+    /* the 9 voxels (y, z) around p, at the bits 3*y + 9*z */
+    unsigned int column(int p) const
+    {
+        const int vertical = mStrides.vertical();
+        const unsigned char* south = mData + p - mStrides.depth();
+        const unsigned char* middle = mData + p;
+        const unsigned char* north = mData + p + mStrides.depth();
+
+        return (unsigned int)(south[-vertical] != 0)
+             | (unsigned int)(south[0] != 0) << 3
+             | (unsigned int)(south[vertical] != 0) << 6
+             | (unsigned int)(middle[-vertical] != 0) << 9
+             | (unsigned int)(middle[0] != 0) << 12
+             | (unsigned int)(middle[vertical] != 0) << 15
+             | (unsigned int)(north[-vertical] != 0) << 18
+             | (unsigned int)(north[0] != 0) << 21
+             | (unsigned int)(north[vertical] != 0) << 24;
+    }
+
+private:
+	/* Member Variables */
+	const unsigned char* mData;
+	Strides mStrides;
+	int mLast;
+	unsigned int mCube;
+};
+
+typedef Basic_neighbourhood_scanner<Runtime_strides> Neighbourhood_scanner;
+
+} // end of namespace Trabecula
+
+#endif // TOPOLOGY_HPP
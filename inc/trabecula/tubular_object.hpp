@@ -11,6 +11,12 @@
 #define TUBULAR_OBJECT_HPP
 
 #include "trabecula/analyze_loader.hpp"
+#include "trabecula/sizes.hpp"
+#include "trabecula/thinning.hpp"
+#include "trabecula/bit_volume.hpp"
+#include "trabecula/components.hpp"
+#include "trabecula/graph.hpp"
+#include "trabecula/arena.hpp"
 
 #include <cstdlib>
 #include <string>
@@ -25,22 +31,6 @@ class Node;
 class Edge;
 
 
-/* Struct storing 3D dimensions and the enlarged dimensions */
-/*	when images are zero-bordered                           */
-struct Sizes
-{
-	unsigned int size_x;
-	unsigned int size_y;
-	unsigned int size_z;
-	unsigned int size_x_enlarged;
-	unsigned int size_y_enlarged;
-	unsigned int size_z_enlarged;
-	unsigned int size;
-	unsigned int size_enlarged;
-	unsigned int xOy_size;
-	unsigned int xOy_enlarged_size;
-};
-
 /********************************************************/
 /* Main class, Tubular_object stores all the structures */
 /* necessary to the analyze of trabeculae :             */
@@ -62,25 +52,34 @@ public:
 
 public:
 	/* Getters */
-    const unsigned char* data() const;
-    const unsigned char* skeleton_data() const;
-    const std::list<Node*>& nodes() const;
-    const std::list<Edge*>& edges() const;
+    const Bit_volume& data() const;
+    const Bit_volume& skeleton_data() const;
+    const Graph& graph() const;
 
     const ANALYZE_DSR* dsr() const;
     const Sizes& sizes() const;
 
+    /* labels of the 26-connected components of the image, and their stats. The clean-up */
+    /* passes free them (see remove_small_components and fill_cavities): call */
+    /* label_components() again after them to measure the components. */
+    const std::vector<unsigned int>& labels() const;
+    const std::vector<Component_stats>& components() const;
+
 public:
 	/* Member Functions */
 	int load_from_file(const std::string& filename);
 	float bv_tv() const;
+    int label_components(unsigned int threads = 0);
+    int remove_small_components(int min_voxels, unsigned int threads = 0, bool keep_labels = false);
+    int fill_cavities(int max_voxels, unsigned int threads = 0);
 	void average_trabecular_length(float values[4]);
 	int number_of_trabeculae();
 	void nodes_connectivity(std::vector<int>& con);
     void tb_th();
     void tb_sp();
     void tb_shape();
-    int skeletonize();
+    int skeletonize(Thinning_mode mode = SEQUENTIAL_THINNING, unsigned int threads = 0,
+                    Volume_layout layout = FLAT_LAYOUT);
     int build_graph();
     int dump_infos();
     int save_skeleton();
@@ -92,18 +91,29 @@ private:
 
 	std::string mFilename;
 
-	unsigned char* mData;
-	unsigned char* mSkeleton;
+	/* binary images with zero borders, one bit per voxel */
+	Bit_volume mData;
+	Bit_volume mSkeleton;
+
+	/* layout used by the thinning of skeletonize() and build_graph() */
+	Volume_layout mLayout;
+
+	/* one label per voxel, once the components are labelled (see label_components), */
+	/* freed by remove_small_components, unless it keeps them, and by fill_cavities; */
+	/* the stats are freed when fill_cavities fills a cavity */
+	std::vector<unsigned int> mLabels;
+	std::vector<Component_stats> mComponents;
 
-	std::list<Node*> mNodes;
-	std::list<Edge*> mEdges;
+	/* graph of the skeleton, once built (see build_graph) */
+	Graph mGraph;
 
 };
 
 ////////////////////////////////////////////////////////////////
 //
-// This is Node class, having connected Edges, voxels on the node
-// and the connectivity (number of edges connected)
+// This is Node class, having voxels on the node and the
+// connectivity (number of edges connected), while the graph
+// is built (see Graph). Its voxels are allocated in an Arena.
 //
 ////////////////////////////////////////////////////////////////
 
@@ -111,8 +121,10 @@ class Node
 {
 
 public:
+    typedef std::list<int, Arena_allocator<int> > Positions;
+
 	/* Constructors/Destructors */
-    Node();
+    explicit Node(Arena& arena);
     ~Node();
 
 public:
@@ -123,28 +135,26 @@ public:
 public:
 	/* Getters */
 	int connectivity() const;
-    const std::list<Edge*>& edges() const;
-    const std::list<int>& positions() const;
+    const Positions& positions() const;
 
 
 public:
 	/* Member Functions */
-    void add_edge(Edge* edge);
     void add_voxel(int indice);
     void remove_voxel(int indice);
 
 private:
 	/* Member Variables */
-	std::list<Edge*> mEdges;
-	std::list<int> mPositions;
+	Positions mPositions;
 	int mConnectivity;
 
 };
 
 ////////////////////////////////////////////////////////////////
 //
-// This is Edge class, having destination and origin nodes,
-// length, and a set of voxels.
+// This is Edge class, having length and a set of voxels,
+// while the graph is built (see Graph). Its voxels are
+// allocated in an Arena.
 //
 ////////////////////////////////////////////////////////////////
 
@@ -152,20 +162,16 @@ class Edge
 {
 
 public:
+    typedef std::deque<int, Arena_allocator<int> > Indices;
+
 	/* Constructors/Destructors */
-    Edge();
+    explicit Edge(Arena& arena);
     ~Edge();
 
-public:
-	/* Setters */
-	void set_nodes(Node* node);
-
 public:
 	/* Getters */
 	float length() const;
-	const Node* first() const;
-	const Node* second() const;
-	const std::deque<int>& data() const;
+	const Indices& data() const;
 
 public:
 	/* Member Functions */
@@ -174,9 +180,7 @@ public:
 private:
 	/* Member Variables */
 	float mLength;
-	std::deque<int> mIndices;
-	Node* mFirst;
-	Node* mSecond;
+	Indices mIndices;
 };
 
 } // end of namespace Trabecula
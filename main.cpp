@@ -1,5 +1,6 @@
 
 #include "trabecula/tubular_object.hpp"
+#include "trabecula/slab_thinning.hpp"
 
 #include <cstdio>
 #include <iostream>
@@ -7,21 +8,42 @@
 #include <cstring>
 #include <cstdlib>
 
-
+// components of the image smaller than this are noise, deleted before the thinning,
+// and cavities up to this size are filled, so that they give no loops of skeleton.
+static const int MIN_COMPONENT_VOXELS = 10;
+static const int MAX_CAVITY_VOXELS = 10;
 
 int main(int argc, char *argv[])
 {
     if(argc < 2)
     {
-        std::cout << "usage: filename without extension" << std::endl;
+        std::cout << "usage: filename without extension [threads] [memory budget in MB]" << std::endl;
         return 0;
     }
     const std::string filename = argv[1];
 
+    // with a number of threads, the skeleton is computed by parallel subfields.
+    Trabecula::Thinning_mode mode = Trabecula::SEQUENTIAL_THINNING;
+    unsigned int threads = 0;
+    if(argc > 2)
+    {
+        mode = Trabecula::SUBFIELD_THINNING;
+        threads = atoi(argv[2]);
+    }
+
+    // with a memory budget, only the skeleton is computed, by slabs of the image file.
+    if(argc > 3)
+    {
+        const std::size_t budget = (std::size_t)atoi(argv[3]) << 20;
+        return Trabecula::skeletonize_file(filename, budget, mode, threads) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
     Trabecula::Tubular_object* cancellous_bones = new Trabecula::Tubular_object();
 
     cancellous_bones->load_from_file(filename);
-    cancellous_bones->skeletonize();
+    cancellous_bones->remove_small_components(MIN_COMPONENT_VOXELS, threads);
+    cancellous_bones->fill_cavities(MAX_CAVITY_VOXELS, threads);
+    cancellous_bones->skeletonize(mode, threads);
     cancellous_bones->build_graph();
     cancellous_bones->save_skeleton();
     cancellous_bones->dump_infos();
@@ -26,6 +26,8 @@
     -> Modifications by Jerome Bouzillard
         anaWriteImagedata : adding this procedure to write image data into a file
         (atm only write 3D images with char size values)
+        anaReadBinaryslices : read z-slices of an image as 0/1 voxels
+        anaWriteImageslices : update z-slices of a char size image file
 
 ******************************************************************************/
 #include "trabecula/swap.hpp"
@@ -297,6 +299,8 @@ int anaWriteImagedata(const char *filename, const ANALYZE_DSR *h, const char *da
     }
 
     fclose(fp);
+
+    return 0;
 }
 /*****************************************************************************/
 
@@ -539,3 +543,87 @@ int anaReadImagedata(const char *filename, const ANALYZE_DSR *h, int frame, char
     return(0);
 }
 /*****************************************************************************/
+
+/*****************************************************************************/
+/* Read the slices [first_slice, first_slice + nb_slices) of the first frame */
+/* as binary voxels: data gets 1 for each non zero voxel, 0 otherwise.       */
+/* The test of a voxel does not depend on its byte order.                    */
+int anaReadBinaryslices(const char *filename, const ANALYZE_DSR *h, int first_slice, int nb_slices, char *data)
+{
+    int pxlSize, sliceNr, i, j;
+    long start_pos, n;
+    char *mdata, *mptr;
+    FILE *fp;
+
+    if(h==NULL || data==NULL || first_slice<0 || nb_slices<1) return 1;
+    if(h->dime.bitpix<8) return 5; /* We don't support bit data */
+
+    pxlSize=h->dime.bitpix/8;
+    sliceNr=h->dime.dim[1]*h->dime.dim[2];
+    mdata=(char*)malloc((size_t)sliceNr*nb_slices*pxlSize); if(mdata==NULL) return 11;
+
+    fp=fopen(filename, "rb");
+    if(fp==NULL)
+    {
+        free(mdata); return 2;
+    }
+
+    start_pos=(long)first_slice*sliceNr*pxlSize;
+    n=(long)h->dime.vox_offset; if(n>0) start_pos+=n;
+    if(fseek(fp, start_pos, SEEK_SET) || ftell(fp)!=start_pos)
+    {
+        fclose(fp); free(mdata); return 7;
+    }
+
+    if(fread(mdata, (size_t)sliceNr*pxlSize, nb_slices, fp) != (size_t)nb_slices)
+    {
+        fclose(fp); free(mdata); return 8;
+    }
+    fclose(fp);
+
+    for(i=0, mptr=mdata; i<sliceNr*nb_slices; i++)
+    {
+        data[i]=0;
+        for(j=0; j<pxlSize; j++, mptr++) if(*mptr) data[i]=1;
+    }
+
+    free(mdata);
+    return 0;
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+/* Write the slices [first_slice, first_slice + nb_slices) of a char size    */
+/* image file, which is created if it does not exist.                        */
+int anaWriteImageslices(const char *filename, const ANALYZE_DSR *h, int first_slice, int nb_slices, const char *data)
+{
+    FILE *fp;
+    long start_pos;
+    size_t size;
+
+    if(h==NULL || data==NULL || first_slice<0 || nb_slices<1) return 1;
+
+    fp=fopen(filename, "r+b");
+    if(fp==NULL) fp=fopen(filename, "w+b");
+    if(fp==NULL)
+    {
+        return 2;
+    }
+
+    size=(size_t)h->dime.dim[1]*h->dime.dim[2];
+    start_pos=(long)first_slice*size;
+    if(fseek(fp, start_pos, SEEK_SET))
+    {
+        fclose(fp); return 7;
+    }
+
+    if(fwrite(data, size, nb_slices, fp) != (size_t)nb_slices)
+    {
+        fclose(fp); return 3;
+    }
+
+    fclose(fp);
+
+    return 0;
+}
+/*****************************************************************************/
@@ -0,0 +1,101 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides a monotonic allocator, for the many small
+/*  objects of the graph passes.
+/*  @implements Arena.
+/*
+/**********************************************************************/
+
+#include "trabecula/arena.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace Trabecula
+{
+
+/***********************************************  Arena  definition  ********************************************************/
+
+/* Constructors/Destructors */
+Arena::Arena(std::size_t block_size) : mBlockSize(block_size), mBlock(0), mNext(0), mEnd(0)
+{
+}
+
+Arena::~Arena()
+{
+    for (std::size_t b = 0; b < mBlocks.size(); ++b)
+    {
+        std::free(mBlocks[b]);
+    }
+}
+
+/* Getters */
+std::size_t Arena::capacity() const
+{
+    std::size_t bytes = 0;
+    for (std::size_t b = 0; b < mBlockSizes.size(); ++b)
+    {
+        bytes += mBlockSizes[b];
+    }
+    return bytes;
+}
+
+/* Member Functions */
+/*******************************************************************************
+*   reset : free every allocation, and start again from the first block.
+*******************************************************************************/
+void Arena::reset()
+{
+    mBlock = 0;
+    mNext = mEnd = 0;
+    if (!mBlocks.empty())
+    {
+        mNext = mBlocks[0];
+        mEnd = mBlocks[0] + mBlockSizes[0];
+    }
+}
+
+/*******************************************************************************
+*   allocate_block : the current block is full. Move to the next kept block
+*                    large enough, skipping the other ones until reset(), or
+*                    add a new block, of the usual size unless bytes is
+*                    larger.
+*******************************************************************************/
+void* Arena::allocate_block(std::size_t bytes, std::size_t alignment)
+{
+    const std::size_t needed = bytes + alignment;
+
+    std::size_t b = mNext ? mBlock + 1 : mBlock;
+    while (b < mBlocks.size() && mBlockSizes[b] < needed)
+    {
+        ++b;
+    }
+
+    if (b == mBlocks.size())
+    {
+        const std::size_t size = needed > mBlockSize ? needed : mBlockSize;
+        char* block = static_cast<char*>(std::malloc(size));
+        if (!block)
+        {
+            throw std::bad_alloc();
+        }
+        mBlocks.push_back(block);
+        mBlockSizes.push_back(size);
+    }
+
+    mBlock = b;
+    mNext = mBlocks[b];
+    mEnd = mBlocks[b] + mBlockSizes[b];
+
+    return allocate(bytes, alignment);
+}
+
+} // end of namespace Trabecula
@@ -0,0 +1,179 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides a binary image packed with one bit per voxel.
+/*  @implements Bit_volume.
+/*
+/**********************************************************************/
+
+#include "trabecula/bit_volume.hpp"
+
+#include <cstring>
+
+namespace Trabecula
+{
+
+/***********************************************  Bit_volume  definition  ***************************************************/
+
+/* Constructors/Destructors */
+Bit_volume::Bit_volume() : mWords(0), mSize(0), mWordCount(0)
+{
+
+}
+
+Bit_volume::Bit_volume(unsigned int size) : mWords(0), mSize(0), mWordCount(0)
+{
+    resize(size);
+}
+
+Bit_volume::~Bit_volume()
+{
+    delete [] mWords;
+}
+
+/* Getters */
+unsigned int Bit_volume::size() const
+{
+    return mSize;
+}
+
+unsigned int Bit_volume::word_count() const
+{
+    return mWordCount;
+}
+
+bool Bit_volume::empty() const
+{
+    return mWords == 0;
+}
+
+unsigned long long* Bit_volume::words()
+{
+    return mWords;
+}
+
+const unsigned long long* Bit_volume::words() const
+{
+    return mWords;
+}
+
+/* Member Functions */
+/*******************************************************************************
+*   resize : reallocate the volume for size voxels, all cleared.
+*******************************************************************************/
+void Bit_volume::resize(unsigned int size)
+{
+    delete [] mWords;
+
+    mSize = size;
+    mWordCount = (size + 63) / 64;
+    mWords = new unsigned long long[mWordCount];
+    clear();
+}
+
+void Bit_volume::clear()
+{
+    memset(mWords, 0, mWordCount * sizeof(unsigned long long));
+}
+
+/*******************************************************************************
+*   count : Return the number of set voxels.
+*******************************************************************************/
+unsigned int Bit_volume::count() const
+{
+    unsigned int count = 0;
+    for (unsigned int w = 0; w < mWordCount; ++w)
+    {
+        count += __builtin_popcountll(mWords[w]);
+    }
+    return count;
+}
+
+/*******************************************************************************
+*   next : Return the first set voxel from p, or size() if there is none.
+*******************************************************************************/
+unsigned int Bit_volume::next(unsigned int p) const
+{
+    if (p >= mSize)
+    {
+        return mSize;
+    }
+
+    unsigned int w = p >> 6;
+    unsigned long long word = mWords[w] & (~0ull << (p & 63));
+
+    while (!word)
+    {
+        if (++w == mWordCount)
+        {
+            return mSize;
+        }
+        word = mWords[w];
+    }
+    return (w << 6) + __builtin_ctzll(word);
+}
+
+/*******************************************************************************
+*   pack : set the voxels from an array of size() bytes.
+*******************************************************************************/
+void Bit_volume::pack(const unsigned char* bytes)
+{
+    const unsigned int full = mSize / 64;
+    unsigned long long word;
+
+    for (unsigned int w = 0; w < full; ++w, bytes += 64)
+    {
+        word = 0;
+        for (int b = 0; b < 64; ++b)
+        {
+            word |= (unsigned long long)(bytes[b] != 0) << b;
+        }
+        mWords[w] = word;
+    }
+
+    if (full < mWordCount)
+    {
+        word = 0;
+        for (unsigned int b = 0; b < mSize - full * 64; ++b)
+        {
+            word |= (unsigned long long)(bytes[b] != 0) << b;
+        }
+        mWords[full] = word;
+    }
+}
+
+/*******************************************************************************
+*   unpack : write the voxels into an array of size() bytes (0 or 1).
+*******************************************************************************/
+void Bit_volume::unpack(unsigned char* bytes) const
+{
+    const unsigned int full = mSize / 64;
+    unsigned long long word;
+
+    for (unsigned int w = 0; w < full; ++w, bytes += 64)
+    {
+        word = mWords[w];
+        for (int b = 0; b < 64; ++b)
+        {
+            bytes[b] = (word >> b) & 1;
+        }
+    }
+
+    if (full < mWordCount)
+    {
+        word = mWords[full];
+        for (unsigned int b = 0; b < mSize - full * 64; ++b)
+        {
+            bytes[b] = (word >> b) & 1;
+        }
+    }
+}
+
+} // end of namespace Trabecula
@@ -0,0 +1,172 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides a binary image stored in 8x8x8 bricks.
+/*  @implements Brick_volume.
+/*
+/**********************************************************************/
+
+#include "trabecula/brick_volume.hpp"
+#include "trabecula/topology.hpp"
+
+#include <cstring>
+
+namespace Trabecula
+{
+
+/***********************************************  UTILITIES  declaration  ***************************************************/
+
+// face case (0 : low face, 1 : inside, 2 : high face) of a coordinate in a brick
+static int face_case(int local);
+
+/***********************************************  Brick_volume  definition  *************************************************/
+
+/* Constructors/Destructors */
+Brick_volume::Brick_volume(const unsigned char* data, const Sizes& sizes) : mSizes(sizes)
+{
+    mBricks[0] = (sizes.size_x_enlarged + BRICK_SIZE - 1) / BRICK_SIZE;
+    mBricks[1] = (sizes.size_y_enlarged + BRICK_SIZE - 1) / BRICK_SIZE;
+    mBricks[2] = (sizes.size_z_enlarged + BRICK_SIZE - 1) / BRICK_SIZE;
+    mSize = mBricks[0] * mBricks[1] * mBricks[2] * BRICK_VOXELS;
+
+    /* storage step of one brick along x, y, z, and of one voxel inside a brick */
+    const int brick_steps[3] = { BRICK_VOXELS, BRICK_VOXELS * mBricks[0], BRICK_VOXELS * mBricks[0] * mBricks[1] };
+    const int voxel_steps[3] = { 1, BRICK_SIZE, BRICK_SIZE * BRICK_SIZE };
+
+    for (int l = 0; l < BRICK_VOXELS; ++l)
+    {
+        mCases[l] = face_case(l % BRICK_SIZE)
+                  + 3 * face_case(l / BRICK_SIZE % BRICK_SIZE)
+                  + 9 * face_case(l / (BRICK_SIZE * BRICK_SIZE));
+    }
+
+    int delta[3];
+    int cases[3];
+    for (int c = 0; c < 27; ++c)
+    {
+        cases[0] = c % 3;
+        cases[1] = c / 3 % 3;
+        cases[2] = c / 9;
+
+        for (int n = 0; n < 26; ++n)
+        {
+            neighbour_delta(n, delta);
+            mOffsets[c][n] = 0;
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (delta[axis] < 0 && cases[axis] == 0)
+                {
+                    // from the low face to the high face of the previous brick
+                    mOffsets[c][n] += (BRICK_SIZE - 1) * voxel_steps[axis] - brick_steps[axis];
+                }
+                else if (delta[axis] > 0 && cases[axis] == 2)
+                {
+                    // from the high face to the low face of the next brick
+                    mOffsets[c][n] += brick_steps[axis] - (BRICK_SIZE - 1) * voxel_steps[axis];
+                }
+                else
+                {
+                    mOffsets[c][n] += delta[axis] * voxel_steps[axis];
+                }
+            }
+        }
+    }
+
+    /* the voxels outside the image, filling the last bricks, are white */
+    mData = new unsigned char[mSize];
+    memset(mData, 0, mSize * sizeof(unsigned char));
+
+    for (int p = 0; p < (int)sizes.size_enlarged; ++p)
+    {
+        mData[storage(p)] = data[p] != 0;
+    }
+}
+
+Brick_volume::~Brick_volume()
+{
+    delete [] mData;
+}
+
+/* Getters */
+unsigned char* Brick_volume::data()
+{
+    return mData;
+}
+
+const unsigned char* Brick_volume::data() const
+{
+    return mData;
+}
+
+const Sizes& Brick_volume::sizes() const
+{
+    return mSizes;
+}
+
+int Brick_volume::size() const
+{
+    return mSize;
+}
+
+/* Member Functions */
+/*******************************************************************************
+*   storage : Return the storage indice of the flat (enlarged) indice p.
+*******************************************************************************/
+int Brick_volume::storage(int p) const
+{
+    const int z = p / mSizes.xOy_enlarged_size;
+    const int r = p - z * mSizes.xOy_enlarged_size;
+    const int y = r / mSizes.size_x_enlarged;
+    const int x = r - y * mSizes.size_x_enlarged;
+
+    const int brick = x / BRICK_SIZE + mBricks[0] * (y / BRICK_SIZE + mBricks[1] * (z / BRICK_SIZE));
+
+    return brick * BRICK_VOXELS
+         + x % BRICK_SIZE + BRICK_SIZE * (y % BRICK_SIZE + BRICK_SIZE * (z % BRICK_SIZE));
+}
+
+/*******************************************************************************
+*   mask : Return the neighbourhood mask of the voxel s.
+*******************************************************************************/
+unsigned int Brick_volume::mask(int s) const
+{
+    const int* offsets = mOffsets[mCases[s & (BRICK_VOXELS - 1)]];
+    unsigned int mask = 0;
+
+    for (int n = 0; n < 26; ++n)
+    {
+        mask |= (unsigned int)mData[s + offsets[n]] << n;
+    }
+    return mask;
+}
+
+/*******************************************************************************
+*   to_flat : copy the voxels into the flat (enlarged) image flat.
+*******************************************************************************/
+void Brick_volume::to_flat(unsigned char* flat) const
+{
+    for (int p = 0; p < (int)mSizes.size_enlarged; ++p)
+    {
+        flat[p] = mData[storage(p)];
+    }
+}
+
+/***********************************************  UTILITIES  definition  ****************************************************/
+static int face_case(int local)
+{
+    if (local == 0)
+    {
+        return 0;
+    }
+    return local == BRICK_SIZE - 1 ? 2 : 1;
+}
+
+} // end of namespace Trabecula
@@ -0,0 +1,282 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides a parallel labelling of the 26-connected
+/*  components of a binary image, and of the 6-connected components
+/*  of its background.
+/*
+/**********************************************************************/
+
+#include "trabecula/components.hpp"
+#include "trabecula/topology.hpp"
+
+#include <algorithm>
+
+namespace Trabecula
+{
+
+/***********************************************  UTILITIES  declaration  ***************************************************/
+
+// mark of the label stored on the root of a component while the other points are labelled
+static const unsigned int ROOT_LABEL = 0x80000000u;
+
+// number of z-slabs given to each thread by the first pass
+static const int SLABS_PER_THREAD = 4;
+
+template <bool Black>
+static int label_points(const unsigned char* data, const Sizes& sizes, unsigned int* labels,
+                        std::vector<Component_stats>& components, Thread_pool& pool,
+                        const int* preceding, int count, int previous_layer_count);
+static unsigned int find_root(unsigned int* parents, unsigned int p);
+static void unite(unsigned int* parents, unsigned int p, unsigned int q);
+
+/******************************************************************************************
+* Label_components : the preceding neighbours of a point are its 13 26-neighbours before
+* it in raster order.
+******************************************************************************************/
+int label_components(const unsigned char* data, const Sizes& sizes, unsigned int* labels,
+                     std::vector<Component_stats>& components, Thread_pool& pool)
+{
+    /* the 13 neighbours preceding a point, the 9 of the previous layer first */
+    int offsets[26];
+    int preceding[13];
+    int delta[3];
+    int count = 0;
+    collect_26_neighbours(0, sizes, offsets);
+    for (int previous_layer = 1; previous_layer >= 0; --previous_layer)
+    {
+        for (int n = 0; n < 26; ++n)
+        {
+            neighbour_delta(n, delta);
+            if (offsets[n] < 0 && (delta[2] < 0) == (previous_layer == 1))
+            {
+                preceding[count++] = offsets[n];
+            }
+        }
+    }
+
+    return label_points<true>(data, sizes, labels, components, pool, preceding, 13, 9);
+}
+
+/******************************************************************************************
+* Label_background_components : the preceding neighbours of a point are its 3
+* 6-neighbours before it in raster order. On the zero borders, the west and up neighbours
+* of a point wrap around to the previous row or layer, but they are border points too, of
+* the first component anyway.
+******************************************************************************************/
+int label_background_components(const unsigned char* data, const Sizes& sizes, unsigned int* labels,
+                                std::vector<Component_stats>& components, Thread_pool& pool)
+{
+    const int preceding[3] = { -(int)sizes.xOy_enlarged_size, -(int)sizes.size_x_enlarged, -1 };
+
+    return label_points<false>(data, sizes, labels, components, pool, preceding, 3, 1);
+}
+
+/***********************************************  UTILITIES  definition  ****************************************************/
+/*******************************************************************************
+*   label_points : union-find of the black (or white) points in two passes
+*                  over z-slabs. Each point starts as its own parent, and the
+*                  root of a set is its smallest point, the first one in
+*                  raster order. The first pass unites each point with its
+*                  preceding neighbours of the same colour, each slab alone,
+*                  so the threads never share a parent. The first layer of
+*                  each slab is then united with the last one of the previous
+*                  slab, through the previous_layer_count first preceding
+*                  neighbours. The second pass sets every parent to its root,
+*                  counts the roots of each slab to number them in raster
+*                  order, then labels every point with the number of its
+*                  root.
+*******************************************************************************/
+template <bool Black>
+static int label_points(const unsigned char* data, const Sizes& sizes, unsigned int* labels,
+                        std::vector<Component_stats>& components, Thread_pool& pool,
+                        const int* preceding, int count, int previous_layer_count)
+{
+    const int layer = sizes.xOy_enlarged_size;
+    const int size_z = sizes.size_z_enlarged;
+    const int depth = std::max(1, size_z / (SLABS_PER_THREAD * (int)pool.size()));
+    const int slabs = (size_z + depth - 1) / depth;
+
+    pool.run(slabs, [&](int s)
+    {
+        const int first = s * depth * layer;
+        const int last = std::min((s + 1) * depth, size_z) * layer;
+
+        for (int p = first; p < last; ++p)
+        {
+            if ((data[p] != 0) != Black)
+            {
+                labels[p] = 0;
+                continue;
+            }
+
+            labels[p] = p;
+            for (int k = 0; k < count; ++k)
+            {
+                const int q = p + preceding[k];
+                if (q >= first && (data[q] != 0) == Black)
+                {
+                    unite(labels, p, q);
+                }
+            }
+        }
+    });
+
+    for (int s = 1; s < slabs; ++s)
+    {
+        const int first = s * depth * layer;
+        for (int p = first; p < first + layer; ++p)
+        {
+            if ((data[p] != 0) == Black)
+            {
+                for (int k = 0; k < previous_layer_count; ++k)
+                {
+                    if ((data[p + preceding[k]] != 0) == Black)
+                    {
+                        unite(labels, p, p + preceding[k]);
+                    }
+                }
+            }
+        }
+    }
+
+    /* the parents are set to the roots while the other threads read them: */
+    /* any parent read is still an ancestor                                */
+    std::vector<int> roots(slabs, 0);
+    pool.run(slabs, [&](int s)
+    {
+        const int last = std::min((s + 1) * depth, size_z) * layer;
+        unsigned int root, parent;
+
+        for (int p = s * depth * layer; p < last; ++p)
+        {
+            if ((data[p] != 0) != Black)
+            {
+                continue;
+            }
+
+            root = p;
+            while ((parent = __atomic_load_n(labels + root, __ATOMIC_RELAXED)) != root)
+            {
+                root = parent;
+            }
+            __atomic_store_n(labels + p, root, __ATOMIC_RELAXED);
+            roots[s] += root == (unsigned int)p;
+        }
+    });
+
+    std::vector<int> first_labels(slabs);
+    int total = 0;
+    for (int s = 0; s < slabs; ++s)
+    {
+        first_labels[s] = total + 1;
+        total += roots[s];
+    }
+    components.resize(total);
+
+    pool.run(slabs, [&](int s)
+    {
+        const int last = std::min((s + 1) * depth, size_z) * layer;
+        unsigned int label = first_labels[s];
+
+        for (int p = s * depth * layer; p < last; ++p)
+        {
+            if ((data[p] != 0) == Black && labels[p] == (unsigned int)p)
+            {
+                components[label - 1].voxels = 0;
+                components[label - 1].first = p;
+                labels[p] = label++ | ROOT_LABEL;
+            }
+        }
+    });
+
+    /* the roots keep their marked label until every point is labelled */
+    pool.run(slabs, [&](int s)
+    {
+        const int last = std::min((s + 1) * depth, size_z) * layer;
+        unsigned int label, run_label = 0;
+        int run = 0;
+
+        for (int p = s * depth * layer; p < last; ++p)
+        {
+            if ((data[p] != 0) != Black)
+            {
+                continue;
+            }
+
+            if (labels[p] & ROOT_LABEL)
+            {
+                label = labels[p] & ~ROOT_LABEL;
+            }
+            else
+            {
+                label = labels[labels[p]] & ~ROOT_LABEL;
+                labels[p] = label;
+            }
+
+            // the points of a run of a row mostly share their label.
+            if (label != run_label)
+            {
+                if (run)
+                {
+                    __atomic_fetch_add(&components[run_label - 1].voxels, run, __ATOMIC_RELAXED);
+                }
+                run_label = label;
+                run = 0;
+            }
+            ++run;
+        }
+
+        if (run)
+        {
+            __atomic_fetch_add(&components[run_label - 1].voxels, run, __ATOMIC_RELAXED);
+        }
+    });
+
+    for (int l = 0; l < total; ++l)
+    {
+        labels[components[l].first] &= ~ROOT_LABEL;
+    }
+
+    return total;
+}
+
+/*******************************************************************************
+*   find_root : Return the root of p, halving the path to it.
+*******************************************************************************/
+static unsigned int find_root(unsigned int* parents, unsigned int p)
+{
+    while (parents[p] != p)
+    {
+        parents[p] = parents[parents[p]];
+        p = parents[p];
+    }
+    return p;
+}
+
+/*******************************************************************************
+*   unite : merge the sets of p and q, under the smaller root.
+*******************************************************************************/
+static void unite(unsigned int* parents, unsigned int p, unsigned int q)
+{
+    p = find_root(parents, p);
+    q = find_root(parents, q);
+
+    if (p < q)
+    {
+        parents[q] = p;
+    }
+    else if (q < p)
+    {
+        parents[p] = q;
+    }
+}
+
+} // end of namespace Trabecula
@@ -0,0 +1,169 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides a parallel exact euclidean distance transform
+/*  of a binary image.
+/*
+/**********************************************************************/
+
+#include "trabecula/distance_transform.hpp"
+
+#include <vector>
+
+namespace Trabecula
+{
+
+/***********************************************  UTILITIES  declaration  ***************************************************/
+
+static void row_distances(const unsigned char* data, int size, unsigned int* distances);
+static void lower_envelope(const unsigned int* g, int size, unsigned int* distances, int* s, int* t);
+
+/******************************************************************************************
+* Squared_distance_transform : implementation of : A general algorithm for computing
+* distance transforms in linear time (Meijster et al., 2000). The distances along x are
+* computed for each row, then the ones along y for each column of these, then the ones
+* along z. Every line of a pass is independent, so the z-layers (or y-rows for the last
+* pass) are shared out among the threads of the pool.
+******************************************************************************************/
+void squared_distance_transform(const unsigned char* data, const Sizes& sizes, unsigned int* distances,
+                                Thread_pool& pool)
+{
+    const int size_x = sizes.size_x_enlarged;
+    const int size_y = sizes.size_y_enlarged;
+    const int size_z = sizes.size_z_enlarged;
+    const int layer = sizes.xOy_enlarged_size;
+
+    pool.run(size_z, [&](int z)
+    {
+        for (int y = 0; y < size_y; ++y)
+        {
+            row_distances(data + z * layer + y * size_x, size_x, distances + z * layer + y * size_x);
+        }
+    });
+
+    pool.run(size_z, [&](int z)
+    {
+        std::vector<unsigned int> g(size_y), d(size_y);
+        std::vector<int> s(size_y), t(size_y);
+        unsigned int* column = distances + z * layer;
+
+        for (int x = 0; x < size_x; ++x)
+        {
+            for (int y = 0; y < size_y; ++y)
+            {
+                g[y] = column[y * size_x + x];
+            }
+            lower_envelope(&g[0], size_y, &d[0], &s[0], &t[0]);
+            for (int y = 0; y < size_y; ++y)
+            {
+                column[y * size_x + x] = d[y];
+            }
+        }
+    });
+
+    pool.run(size_y, [&](int y)
+    {
+        std::vector<unsigned int> g(size_z), d(size_z);
+        std::vector<int> s(size_z), t(size_z);
+        unsigned int* column = distances + y * size_x;
+
+        for (int x = 0; x < size_x; ++x)
+        {
+            for (int z = 0; z < size_z; ++z)
+            {
+                g[z] = column[z * layer + x];
+            }
+            lower_envelope(&g[0], size_z, &d[0], &s[0], &t[0]);
+            for (int z = 0; z < size_z; ++z)
+            {
+                column[z * layer + x] = d[z];
+            }
+        }
+    });
+}
+
+/***********************************************  UTILITIES  definition  ****************************************************/
+/*******************************************************************************
+*   row_distances : squared distances of the points of a row, whose first and
+*                   last points are white, to the nearest white point of the row.
+*******************************************************************************/
+static void row_distances(const unsigned char* data, int size, unsigned int* distances)
+{
+    unsigned int d = 0;
+    for (int x = 0; x < size; ++x)
+    {
+        d = data[x] ? d + 1 : 0;
+        distances[x] = d;
+    }
+
+    d = 0;
+    for (int x = size - 1; x >= 0; --x)
+    {
+        d = data[x] ? d + 1 : 0;
+        if (d < distances[x])
+        {
+            distances[x] = d;
+        }
+        distances[x] *= distances[x];
+    }
+}
+
+/*******************************************************************************
+*   lower_envelope : distances[u] = min over i of (u - i)^2 + g[i], from the
+*                    lower envelope of these parabolas. s holds the apex of
+*                    each parabola of the envelope, t the first point where it
+*                    is the lowest.
+*******************************************************************************/
+static void lower_envelope(const unsigned int* g, int size, unsigned int* distances, int* s, int* t)
+{
+    int q = 0;
+    s[0] = 0;
+    t[0] = 0;
+
+    for (int u = 1; u < size; ++u)
+    {
+        while (q >= 0 && (long long)(t[q] - s[q]) * (t[q] - s[q]) + g[s[q]] > (long long)(t[q] - u) * (t[q] - u) + g[u])
+        {
+            --q;
+        }
+
+        if (q < 0)
+        {
+            q = 0;
+            s[0] = u;
+        }
+        else
+        {
+            // first point where the parabola of u is below the one of s[q], by floor division.
+            const long long i = s[q];
+            const long long numerator = (long long)u * u - i * i + (long long)g[u] - g[i];
+            const long long denominator = 2 * (u - i);
+            const long long w = 1 + (numerator >= 0 ? numerator / denominator : -((-numerator + denominator - 1) / denominator));
+
+            if (w < size)
+            {
+                ++q;
+                s[q] = u;
+                t[q] = w;
+            }
+        }
+    }
+
+    for (int u = size - 1; u >= 0; --u)
+    {
+        distances[u] = (unsigned int)((u - s[q]) * (u - s[q])) + g[s[q]];
+        if (u == t[q])
+        {
+            --q;
+        }
+    }
+}
+
+} // end of namespace Trabecula
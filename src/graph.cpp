@@ -0,0 +1,92 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides the flat arrays graph of a skeleton.
+/*  @implements Graph.
+/*
+/**********************************************************************/
+
+#include "trabecula/graph.hpp"
+
+namespace Trabecula
+{
+
+/***********************************************  Graph  definition  ********************************************************/
+
+/* Constructors/Destructors */
+Graph::Graph() : mNodeOffsets(1, 0), mAdjacencyOffsets(1, 0), mEdgeOffsets(1, 0)
+{
+}
+
+/* Getters */
+const std::vector<int>& Graph::connectivities() const
+{
+    return mConnectivities;
+}
+
+const std::vector<float>& Graph::lengths() const
+{
+    return mLengths;
+}
+
+/* Member Functions */
+void Graph::clear()
+{
+    mConnectivities.clear();
+    mNodeOffsets.assign(1, 0);
+    mNodeVoxels.clear();
+    mAdjacencyOffsets.assign(1, 0);
+    mAdjacency.clear();
+
+    mLengths.clear();
+    mEdgeOffsets.assign(1, 0);
+    mEdgeVoxels.clear();
+    mEdgeNodes.clear();
+}
+
+void Graph::connect(int node, int edge)
+{
+    mEdgeNodes[2 * edge + (mEdgeNodes[2 * edge] != -1)] = node;
+}
+
+/*******************************************************************************
+*   build_adjacency : counting sort of the (edge, node) pairs by node. The
+*                     edges of a node keep the increasing order of their ids.
+*******************************************************************************/
+void Graph::build_adjacency()
+{
+    const int nodes = node_count();
+    mAdjacencyOffsets.assign(nodes + 1, 0);
+
+    for (std::size_t i = 0; i < mEdgeNodes.size(); ++i)
+    {
+        if (mEdgeNodes[i] != -1)
+        {
+            ++mAdjacencyOffsets[mEdgeNodes[i] + 1];
+        }
+    }
+
+    for (int n = 0; n < nodes; ++n)
+    {
+        mAdjacencyOffsets[n + 1] += mAdjacencyOffsets[n];
+    }
+
+    mAdjacency.resize(mAdjacencyOffsets[nodes]);
+    std::vector<int> next(mAdjacencyOffsets.begin(), mAdjacencyOffsets.end() - 1);
+    for (std::size_t i = 0; i < mEdgeNodes.size(); ++i)
+    {
+        if (mEdgeNodes[i] != -1)
+        {
+            mAdjacency[next[mEdgeNodes[i]]++] = i / 2;
+        }
+    }
+}
+
+} // end of namespace Trabecula
@@ -0,0 +1,100 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides the voxel labels of the nodes and edges of the
+/*  graph being built.
+/*  @implements Graph_labels.
+/*
+/**********************************************************************/
+
+#include "trabecula/graph_labels.hpp"
+#include "trabecula/tubular_object.hpp"
+
+#include <new>
+
+namespace Trabecula
+{
+
+/***********************************************  Graph_labels  definition  *************************************************/
+
+/* Constructors/Destructors */
+Graph_labels::Graph_labels(const Sizes& sizes) : mLabels(sizes.size_enlarged, 0)
+{
+}
+
+/* Member Functions */
+/*******************************************************************************
+*   add_node : Return the label of a new node, -1, -2...
+*******************************************************************************/
+int Graph_labels::add_node()
+{
+    mNodes.push_back(new (mArena.allocate(sizeof(Node), alignof(Node))) Node(mArena));
+    return -(int)mNodes.size();
+}
+
+/*******************************************************************************
+*   add_edge : Return the label of a new edge, 1, 2...
+*******************************************************************************/
+int Graph_labels::add_edge()
+{
+    mEdges.push_back(new (mArena.allocate(sizeof(Edge), alignof(Edge))) Edge(mArena));
+    return (int)mEdges.size();
+}
+
+/*******************************************************************************
+*   remove : the memory of the node or edge is freed by clear().
+*******************************************************************************/
+void Graph_labels::remove(int label)
+{
+    if (label < 0)
+    {
+        mNodes[-label - 1] = 0;
+    }
+    else if (label > 0)
+    {
+        mEdges[label - 1] = 0;
+    }
+}
+
+/*******************************************************************************
+*   clear : only the voxels of the nodes and edges are cleared, so the cost
+*           follows the size of the graph, not of the image. The nodes and
+*           edges are not destroyed: all their memory is in the arena.
+*******************************************************************************/
+void Graph_labels::clear()
+{
+    for (std::size_t n = 0; n < mNodes.size(); ++n)
+    {
+        if (mNodes[n])
+        {
+            for (Node::Positions::const_iterator it = mNodes[n]->positions().begin(); it != mNodes[n]->positions().end(); ++it)
+            {
+                mLabels[*it] = 0;
+            }
+        }
+    }
+
+    for (std::size_t e = 0; e < mEdges.size(); ++e)
+    {
+        if (mEdges[e])
+        {
+            for (Edge::Indices::const_iterator it = mEdges[e]->data().begin(); it != mEdges[e]->data().end(); ++it)
+            {
+                mLabels[*it] = 0;
+            }
+        }
+    }
+
+    mNodes.clear();
+    mEdges.clear();
+    mArena.reset();
+}
+
+} // end of namespace Trabecula
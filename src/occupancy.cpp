@@ -0,0 +1,153 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides a coarse occupancy map of a binary image, to
+/*  skip its empty blocks.
+/*  @implements Occupancy.
+/*
+/**********************************************************************/
+
+#include "trabecula/occupancy.hpp"
+
+#include <algorithm>
+
+namespace Trabecula
+{
+
+/***********************************************  Occupancy  definition  ****************************************************/
+
+/* Constructors/Destructors */
+Occupancy::Occupancy(const Sizes& sizes) : mSizes(sizes),
+    mBlocksX((sizes.size_x_enlarged + BRICK_SIZE - 1) / BRICK_SIZE),
+    mBlocksY((sizes.size_y_enlarged + BRICK_SIZE - 1) / BRICK_SIZE),
+    mBlocksZ((sizes.size_z_enlarged + BRICK_SIZE - 1) / BRICK_SIZE),
+    mCounts(mBlocksX * mBlocksY * mBlocksZ), mOccupied(mBlocksX * mBlocksY * mBlocksZ), mRunFirst(0), mRunLast(0)
+{
+}
+
+/* Member Functions */
+/*******************************************************************************
+*   build : count the black voxels of each block of a byte image.
+*******************************************************************************/
+void Occupancy::build(const unsigned char* data)
+{
+    std::fill(mCounts.begin(), mCounts.end(), 0);
+    mOccupied.clear();
+    mRunFirst = mRunLast = 0;
+
+    for (int i = 0; i < (int)mSizes.size_enlarged; ++i)
+    {
+        if (data[i])
+        {
+            add(i);
+        }
+    }
+}
+
+/*******************************************************************************
+*   build : count the black voxels of each block of a packed image, in time
+*           proportional to its words and black voxels.
+*******************************************************************************/
+void Occupancy::build(const Bit_volume& data)
+{
+    std::fill(mCounts.begin(), mCounts.end(), 0);
+    mOccupied.clear();
+    mRunFirst = mRunLast = 0;
+
+    for (unsigned int i = data.next(0); i < data.size(); i = data.next(i + 1))
+    {
+        add(i);
+    }
+}
+
+void Occupancy::add(int p)
+{
+    const int b = block(p);
+    if (mCounts[b]++ == 0)
+    {
+        mOccupied.set(b);
+    }
+}
+
+void Occupancy::remove(int p)
+{
+    const int b = block(p);
+    if (--mCounts[b] == 0)
+    {
+        mOccupied.reset(b);
+    }
+}
+
+/*******************************************************************************
+*   next_run : from the row of p, find the next marked block of the row of
+*              blocks, and the run of marked blocks it starts. When there is
+*              none, go to the next row, or to the first row of the next row
+*              of blocks when the whole row of blocks is empty. A block
+*              unmarked after the run was found is still visited, which
+*              the marks allow.
+*******************************************************************************/
+unsigned int Occupancy::next_run(unsigned int p) const
+{
+    const int size_x = mSizes.size_x_enlarged;
+    const int size_y = mSizes.size_y_enlarged;
+
+    while (p < mSizes.size_enlarged)
+    {
+        const int row = p / size_x;
+        const int x = p - row * size_x;
+        const int y = row % size_y;
+        const int z = row / size_y;
+        const int blocks_row = ((z / BRICK_SIZE) * mBlocksY + y / BRICK_SIZE) * mBlocksX;
+        const int b = mOccupied.next(blocks_row + x / BRICK_SIZE);
+
+        if (b < blocks_row + mBlocksX)
+        {
+            int last = b + 1;
+            while (last < blocks_row + mBlocksX && mOccupied.test(last))
+            {
+                ++last;
+            }
+
+            mRunFirst = row * size_x + (b - blocks_row) * BRICK_SIZE;
+            mRunLast = row * size_x + std::min((last - blocks_row) * BRICK_SIZE, size_x);
+            return std::max(p, mRunFirst);
+        }
+
+        if (mOccupied.next(blocks_row) < (unsigned int)(blocks_row + mBlocksX))
+        {
+            p = (row + 1) * size_x;
+        }
+        else
+        {
+            // the row of blocks is empty.
+            const int next_y = std::min((y / BRICK_SIZE + 1) * BRICK_SIZE, size_y);
+            p = (z * size_y + next_y) * size_x;
+        }
+    }
+
+    return mSizes.size_enlarged;
+}
+
+/*******************************************************************************
+*   block : index of the block of the voxel p.
+*******************************************************************************/
+int Occupancy::block(int p) const
+{
+    const int size_x = mSizes.size_x_enlarged;
+    const int size_y = mSizes.size_y_enlarged;
+    const int row = p / size_x;
+    const int x = p - row * size_x;
+    const int y = row % size_y;
+    const int z = row / size_y;
+
+    return ((z / BRICK_SIZE) * mBlocksY + y / BRICK_SIZE) * mBlocksX + x / BRICK_SIZE;
+}
+
+} // end of namespace Trabecula
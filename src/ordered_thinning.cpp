@@ -0,0 +1,120 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides a thinning of a binary image in the order of
+/*  the distance to the background.
+/*  @implements Ordered_thinning.
+/*
+/**********************************************************************/
+
+#include "trabecula/ordered_thinning.hpp"
+#include "trabecula/distance_transform.hpp"
+#include "trabecula/topology.hpp"
+
+namespace Trabecula
+{
+
+/***********************************************  Ordered_thinning  definition  *********************************************/
+
+/* Constructors/Destructors */
+Ordered_thinning::Ordered_thinning(unsigned char* data, const Sizes& sizes) : mData(data), mSizes(sizes),
+    mFirst(sizes.xOy_enlarged_size), mLast(sizes.size_enlarged - sizes.xOy_enlarged_size),
+    mWaiting(sizes.size_enlarged)
+{
+    collect_26_neighbours(0, mSizes, mOffsets);
+}
+
+/* Getters */
+const std::vector<unsigned int>& Ordered_thinning::distances() const
+{
+    return mDistances;
+}
+
+/* Member Functions */
+/*******************************************************************************
+*   run : thin the image, and return the number of deleted points. The black
+*         points are queued in raster order in the bucket of their distance,
+*         then the buckets are emptied in increasing distance order.
+*******************************************************************************/
+int Ordered_thinning::run(Thread_pool& pool)
+{
+    const Simple_point_table& simple_points = Simple_point_table::instance();
+    Neighbourhood_scanner scanner(mData, mSizes);
+    unsigned int mask;
+    int deleted = 0;
+
+    mDistances.resize(mSizes.size_enlarged);
+    squared_distance_transform(mData, mSizes, &mDistances[0], pool);
+
+    for (int p = mFirst; p < mLast; ++p)
+    {
+        if (mData[p])
+        {
+            if (mDistances[p] >= mBuckets.size())
+            {
+                mBuckets.resize(mDistances[p] + 1);
+            }
+            mBuckets[mDistances[p]].push_back(p);
+        }
+    }
+
+    for (std::size_t d = 0; d < mBuckets.size(); ++d)
+    {
+        std::vector<int>& bucket = mBuckets[d];
+
+        // the bucket grows with the waiting points put back by the deletions.
+        for (std::size_t i = 0; i < bucket.size(); ++i)
+        {
+            const int p = bucket[i];
+            if (!mData[p])
+            {
+                continue;
+            }
+
+            mask = scanner.mask(p);
+            if( (mask & 0x3F) != 0x3F && count_neighbours(mask) > 1 && simple_points.is_simple(mask) )
+            {
+                erase(p, bucket);
+                scanner.reset();
+                ++deleted;
+            }
+            else
+            {
+                mWaiting.set(p);
+            }
+        }
+
+        std::vector<int>().swap(bucket);
+    }
+
+    return deleted;
+}
+
+/*******************************************************************************
+*   erase : delete the point p, and put its waiting neighbours back in the
+*           bucket.
+*******************************************************************************/
+void Ordered_thinning::erase(int p, std::vector<int>& bucket)
+{
+    mData[p] = 0;
+
+    int q;
+    for (int n = 0; n < 26; ++n)
+    {
+        q = p + mOffsets[n];
+        if (mWaiting.test(q))
+        {
+            mWaiting.reset(q);
+            bucket.push_back(q);
+        }
+    }
+}
+
+} // end of namespace Trabecula
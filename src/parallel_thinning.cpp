@@ -0,0 +1,276 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides a fully parallel thinning of a binary image,
+/*  by 12 directional subiterations.
+/*  @implements Parallel_thinning.
+/*
+/**********************************************************************/
+
+#include "trabecula/parallel_thinning.hpp"
+#include "trabecula/topology.hpp"
+
+#include <algorithm>
+
+namespace Trabecula
+{
+
+/***********************************************  UTILITIES  declaration  ***************************************************/
+
+// 6-neighbours (bits of a neighbourhood mask : U N W E S D) of the pair of directions of
+// each subiteration : US, NE, DW, SE, UW, DN, SW, UN, DE, NW, UE, DS
+static const unsigned int SUBITERATION_DIRECTIONS[12] = {
+    0x11, 0x0A, 0x24, 0x18, 0x05, 0x22, 0x14, 0x03, 0x28, 0x06, 0x09, 0x30
+                                                        };
+
+// number of points tested by a task
+static const int CHUNK = 1024;
+
+/***********************************************  Parallel_thinning  definition  ********************************************/
+
+/* Constructors/Destructors */
+Parallel_thinning::Parallel_thinning(unsigned char* data, const Sizes& sizes) : mData(data), mSizes(sizes),
+    mFirst(sizes.xOy_enlarged_size), mLast(sizes.size_enlarged - sizes.xOy_enlarged_size),
+    mOnSurface(sizes.size_enlarged), mIsCandidate(sizes.size_enlarged)
+{
+    collect_26_neighbours(0, mSizes, mOffsets);
+
+    mPreceding = 0;
+    for (int n = 0; n < 26; ++n)
+    {
+        if (mOffsets[n] < 0)
+        {
+            mPreceding |= 1u << n;
+        }
+    }
+}
+
+/* Member Functions */
+/*******************************************************************************
+*   seed_all : collect the black points of the image with a white
+*              6-neighbour.
+*******************************************************************************/
+void Parallel_thinning::seed_all()
+{
+    const int size_x = mSizes.size_x_enlarged;
+    int p;
+
+    for (int z = 1; z + 1 < (int)mSizes.size_z_enlarged; ++z)
+    {
+        for (int y = 1; y + 1 < (int)mSizes.size_y_enlarged; ++y)
+        {
+            p = z * mSizes.xOy_enlarged_size + y * size_x + 1;
+            for (int x = 1; x + 1 < size_x; ++x, ++p)
+            {
+                if (mData[p] && (!mData[p + mOffsets[0]] || !mData[p + mOffsets[1]] || !mData[p + mOffsets[2]] ||
+                                 !mData[p + mOffsets[3]] || !mData[p + mOffsets[4]] || !mData[p + mOffsets[5]]))
+                {
+                    mSurface.push_back(p);
+                    mOnSurface.set(p);
+                }
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+*   run : compute the 12 subiterations until no points are deleted, and
+*         return the number of deleted points.
+*******************************************************************************/
+int Parallel_thinning::run(Thread_pool& pool)
+{
+    int deleted = 0;
+    int modified;
+
+    do
+    {
+        modified = iterate(pool);
+        deleted += modified;
+
+    } while(modified > 0);
+
+    return deleted;
+}
+
+/*******************************************************************************
+*   iterate : compute the 12 subiterations once, and return the number of
+*             deleted points.
+*******************************************************************************/
+int Parallel_thinning::iterate(Thread_pool& pool)
+{
+    int modified = 0;
+
+    for (int s = 0; s < 12; ++s)
+    {
+        modified += subiter(s, pool);
+    }
+
+    return modified;
+}
+
+/*******************************************************************************
+*   subiter : Return the number of deleted points in a subiteration. The
+*             candidates are found in parallel, then the points to delete
+*             among them, then they are deleted.
+*******************************************************************************/
+int Parallel_thinning::subiter(int subiteration, Thread_pool& pool)
+{
+    const Simple_point_table& simple_points = Simple_point_table::instance();
+    const unsigned int directions = SUBITERATION_DIRECTIONS[subiteration];
+    int modified = 0;
+
+    // drop the deleted points of the surface.
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < mSurface.size(); ++i)
+    {
+        if (mData[mSurface[i]])
+        {
+            mSurface[kept++] = mSurface[i];
+        }
+        else
+        {
+            mOnSurface.reset(mSurface[i]);
+        }
+    }
+    mSurface.resize(kept);
+
+    const int tasks = (mSurface.size() + CHUNK - 1) / CHUNK;
+    if (mCandidates.size() < (std::size_t)tasks)
+    {
+        mCandidates.resize(tasks);
+        mDeletable.resize(tasks);
+    }
+
+    // simple and non end points that are border points of one of the directions.
+    pool.run(tasks, [&](int t)
+    {
+        Neighbourhood_scanner scanner(mData, mSizes);
+        std::vector<int>& candidates = mCandidates[t];
+        const std::size_t end = std::min(mSurface.size(), (std::size_t)(t + 1) * CHUNK);
+        unsigned int mask;
+
+        candidates.clear();
+        for (std::size_t i = (std::size_t)t * CHUNK; i < end; ++i)
+        {
+            mask = scanner.mask(mSurface[i]);
+
+            if( (mask & directions) != directions && count_neighbours(mask) > 1 && simple_points.is_simple(mask) )
+            {
+                candidates.push_back(mSurface[i]);
+            }
+        }
+    });
+
+    for (int t = 0; t < tasks; ++t)
+    {
+        for (std::size_t i = 0; i < mCandidates[t].size(); ++i)
+        {
+            mIsCandidate.set(mCandidates[t][i]);
+        }
+    }
+
+    // candidates that stay deletable whatever preceding candidates are deleted.
+    pool.run(tasks, [&](int t)
+    {
+        Neighbourhood_scanner scanner(mData, mSizes);
+        const std::vector<int>& candidates = mCandidates[t];
+        std::vector<int>& deletable = mDeletable[t];
+        unsigned int mask, preceding, neighbours;
+        int p;
+
+        deletable.clear();
+        for (std::size_t i = 0; i < candidates.size(); ++i)
+        {
+            p = candidates[i];
+            mask = scanner.mask(p);
+
+            preceding = 0;
+            for (neighbours = mask & mPreceding; neighbours; neighbours &= neighbours - 1)
+            {
+                if (mIsCandidate.test(p + mOffsets[first_neighbour(neighbours)]))
+                {
+                    preceding |= neighbours & -neighbours;
+                }
+            }
+
+            if (is_deletable(mask, preceding))
+            {
+                deletable.push_back(p);
+            }
+        }
+    });
+
+    for (int t = 0; t < tasks; ++t)
+    {
+        for (std::size_t i = 0; i < mCandidates[t].size(); ++i)
+        {
+            mIsCandidate.reset(mCandidates[t][i]);
+        }
+    }
+
+    for (int t = 0; t < tasks; ++t)
+    {
+        for (std::size_t i = 0; i < mDeletable[t].size(); ++i)
+        {
+            erase(mDeletable[t][i]);
+            ++modified;
+        }
+    }
+
+    return modified;
+}
+
+/*******************************************************************************
+*   is_deletable : Return true when the point of neighbourhood mask stays
+*                  simple and non end for any deletion of the neighbours in
+*                  preceding.
+*******************************************************************************/
+bool Parallel_thinning::is_deletable(unsigned int mask, unsigned int preceding) const
+{
+    const Simple_point_table& simple_points = Simple_point_table::instance();
+    unsigned int deleted = preceding;
+    unsigned int remaining;
+
+    while (true)
+    {
+        remaining = mask & ~deleted;
+        if (count_neighbours(remaining) <= 1 || !simple_points.is_simple(remaining))
+        {
+            return false;
+        }
+
+        if (!deleted)
+        {
+            return true;
+        }
+        deleted = (deleted - 1) & preceding;
+    }
+}
+
+/*******************************************************************************
+*   erase : delete the point p. Its black 6-neighbours join the surface.
+*******************************************************************************/
+void Parallel_thinning::erase(int p)
+{
+    mData[p] = 0;
+
+    int q;
+    for (int n = 0; n < 6; ++n)
+    {
+        q = p + mOffsets[n];
+        if (mData[q] && q >= mFirst && q < mLast && !mOnSurface.test(q))
+        {
+            mOnSurface.set(q);
+            mSurface.push_back(q);
+        }
+    }
+}
+
+} // end of namespace Trabecula
@@ -0,0 +1,162 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides the alternative simple point tests.
+/*  @implements Euler_simple_test, Decision_tree_simple_test.
+/*
+/**********************************************************************/
+
+#include "trabecula/simple_tests.hpp"
+
+#include <unordered_map>
+
+namespace Trabecula
+{
+
+/***********************************************  Euler_simple_test  definition  ********************************************/
+
+/* Constructors/Destructors */
+/*******************************************************************************
+*   Euler_simple_test : the octant of signs (sx, sy, sz) holds the central
+*   point p and its neighbours x, y, z, xy, xz, yz, xyz (bits 0 to 6) in that
+*   direction. Deleting p removes the cells of its closed cube that no other
+*   black point covers : in the octant, the vertex (shared by 8 points), 3
+*   edges (by 4 points, 2 octants each), 3 faces (by 2 points, 4 octants each)
+*   and an eighth of the cube. Counted 8 times, vertices and faces with +, and
+*   edges and the cube with -, they sum to 8 times the change of the Euler
+*   characteristic.
+*******************************************************************************/
+Euler_simple_test::Euler_simple_test()
+{
+    for (int c = 0; c < 128; ++c)
+    {
+        const bool x = c & 1, y = c & 2, z = c & 4, xy = c & 8, xz = c & 16, yz = c & 32;
+
+        mEuler[c] = (c == 0 ? 8 : 0)
+                  - 4 * (!(y || z || yz) + !(x || z || xz) + !(x || y || xy))
+                  + 2 * (!x + !y + !z)
+                  - 1;
+    }
+
+    int delta[3];
+    for (int o = 0; o < 8; ++o)
+    {
+        const int sx = o & 1 ? 1 : -1, sy = o & 2 ? 1 : -1, sz = o & 4 ? 1 : -1;
+        const int offsets[7][3] = { {sx, 0, 0}, {0, sy, 0}, {0, 0, sz}, {sx, sy, 0}, {sx, 0, sz}, {0, sy, sz},
+                                    {sx, sy, sz} };
+
+        for (int k = 0; k < 7; ++k)
+        {
+            for (int n = 0; n < 26; ++n)
+            {
+                neighbour_delta(n, delta);
+                if (delta[0] == offsets[k][0] && delta[1] == offsets[k][1] && delta[2] == offsets[k][2])
+                {
+                    mOctants[o][k] = n;
+                }
+            }
+        }
+    }
+}
+
+/* Member Functions */
+bool Euler_simple_test::is_simple(unsigned int mask) const
+{
+    int euler = 0;
+    for (int o = 0; o < 8; ++o)
+    {
+        const int* octant = mOctants[o];
+        const unsigned int c = ((mask >> octant[0]) & 1)
+                             | ((mask >> octant[1]) & 1) << 1
+                             | ((mask >> octant[2]) & 1) << 2
+                             | ((mask >> octant[3]) & 1) << 3
+                             | ((mask >> octant[4]) & 1) << 4
+                             | ((mask >> octant[5]) & 1) << 5
+                             | ((mask >> octant[6]) & 1) << 6;
+        euler += mEuler[c];
+    }
+
+    return euler == 0 && is_26_connected(mask);
+}
+
+/***********************************************  Decision_tree_simple_test  definition  ************************************/
+
+/* Constructors/Destructors */
+/*******************************************************************************
+*   Decision_tree_simple_test : the diagram is built bottom up from the
+*   table. The leaves are the distinct words of the 64 configurations of the
+*   6-adjacent neighbours, then each level of the tree tests the next bit of
+*   the mask, from 6 to 25, and reuses the node of the same children.
+*******************************************************************************/
+Decision_tree_simple_test::Decision_tree_simple_test()
+{
+    const Simple_point_table& table = Simple_point_table::instance();
+    std::vector<int> level(NEIGHBOURHOOD_SIZE >> 6);
+
+    std::unordered_map<unsigned long long, int> leaves;
+    for (unsigned int j = 0; j < level.size(); ++j)
+    {
+        unsigned long long word = 0;
+        for (unsigned int i = 0; i < 64; ++i)
+        {
+            word |= (unsigned long long)table.is_simple(j << 6 | i) << i;
+        }
+
+        std::unordered_map<unsigned long long, int>::iterator it = leaves.find(word);
+        if (it == leaves.end())
+        {
+            it = leaves.insert(std::make_pair(word, (int)mLeaves.size())).first;
+            mLeaves.push_back(word);
+        }
+        level[j] = ~it->second;
+    }
+
+    std::unordered_map<unsigned long long, int> nodes;
+    for (int bit = 6; bit < 26; ++bit)
+    {
+        nodes.clear();
+        for (unsigned int j = 0; j < level.size() / 2; ++j)
+        {
+            const int low = level[2 * j];
+            const int high = level[2 * j + 1];
+            if (low == high)
+            {
+                level[j] = low;
+                continue;
+            }
+
+            const unsigned long long key = (unsigned long long)(unsigned int)low << 32 | (unsigned int)high;
+            std::unordered_map<unsigned long long, int>::iterator it = nodes.find(key);
+            if (it == nodes.end())
+            {
+                const Node node = { bit, low, high };
+                it = nodes.insert(std::make_pair(key, (int)mNodes.size())).first;
+                mNodes.push_back(node);
+            }
+            level[j] = it->second;
+        }
+        level.resize(level.size() / 2);
+    }
+
+    mRoot = level[0];
+}
+
+/* Getters */
+std::size_t Decision_tree_simple_test::nodes() const
+{
+    return mNodes.size();
+}
+
+std::size_t Decision_tree_simple_test::leaves() const
+{
+    return mLeaves.size();
+}
+
+} // end of namespace Trabecula
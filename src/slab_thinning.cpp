@@ -0,0 +1,277 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides the thinning of an Analyze image too large to
+/*  be loaded, by z-slabs read from and written back to the
+/*  skeleton file.
+/*
+/**********************************************************************/
+
+#include "trabecula/slab_thinning.hpp"
+#include "trabecula/analyze_loader.hpp"
+#include "trabecula/parallel_thinning.hpp"
+#include "trabecula/ordered_thinning.hpp"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+namespace Trabecula
+{
+
+/***********************************************  UTILITIES  declaration  ***************************************************/
+
+// estimated bytes per voxel of a slab : the slab, the slices read from the file,
+// and the border arrays of the thinning.
+static const std::size_t SLAB_BYTES_PER_VOXEL = 4;
+
+// the ordered thinning adds the distances (4), and the buckets of the black points,
+// up to 8 while they grow, and the waiting bits.
+static const std::size_t ORDERED_SLAB_BYTES_PER_VOXEL = 1 + 1 + 4 + 8;
+
+static void slab_sizes(const Sizes& sizes, int depth, Sizes& slab);
+static int read_slab(const char* filename, const ANALYZE_DSR* dsr, const Sizes& sizes, int z, int depth,
+                     unsigned char* slab, char* slices);
+static int write_slab(const char* filename, const ANALYZE_DSR* dsr, const Sizes& sizes, int z, int depth,
+                      const unsigned char* slab, char* slices);
+
+/******************************************************************************************
+* Skeletonize_file : the skeleton file starts as a binary copy of the image. Then each
+* pass computes one iteration (the 6, or 12, subiterations, or a whole ordered thinning)
+* on every slab that may change: a slab is read with one halo layer on each side, the
+* halo layers are never deleted, and the slab is written back. A slab needs a new
+* iteration when it or one of its neighbours deleted points since its last one, so the
+* passes stop when no slab changes.
+* Every deletion is tested on its whole 26-neighbourhood, so the topology is preserved,
+* but the points are visited slab by slab: the skeleton may differ from the one computed
+* in memory.
+******************************************************************************************/
+int skeletonize_file(const std::string& filename, std::size_t memory_budget,
+                     Thinning_mode mode, unsigned int threads)
+{
+    ANALYZE_DSR dsr;
+    const std::string header_filename = filename + ".hdr";
+    const std::string image_filename = filename + ".img";
+
+    if(anaReadHeader(header_filename.c_str(), &dsr))
+    {
+        std::cerr << "Image header read failed!" << std::endl;
+        return 1;
+    }
+
+    Sizes sizes;
+    sizes.size_x = dsr.dime.dim[1];
+    sizes.size_y = dsr.dime.dim[2];
+    slab_sizes(sizes, dsr.dime.dim[3], sizes);
+
+    /* thickest slab that fits in the budget with its 2 halo layers */
+    const std::size_t bytes_per_voxel = mode == ORDERED_THINNING ? ORDERED_SLAB_BYTES_PER_VOXEL : SLAB_BYTES_PER_VOXEL;
+    const std::size_t layers = memory_budget / ((std::size_t)sizes.xOy_enlarged_size * bytes_per_voxel);
+    if(layers < 3)
+    {
+        std::cerr << "error, the memory budget is smaller than one slab!" << std::endl;
+        return 2;
+    }
+    const int depth = std::min<std::size_t>(layers, sizes.size_z + 2) - 2;
+    const int slabs = (sizes.size_z + depth - 1) / depth;
+
+    /* the skeleton is a char size image, named as by Tubular_object::save_skeleton */
+    ANALYZE_DSR skeleton_dsr = dsr;
+    skeleton_dsr.dime.datatype = ANALYZE_DT_UNSIGNED_CHAR;
+    skeleton_dsr.dime.bitpix = 8;
+    skeleton_dsr.dime.vox_offset = 0.0;
+
+    const std::string name = filename.substr(filename.find_last_of("/") + 1);
+    const std::string skeleton_filename = name + "_skeleton.img";
+
+    if(anaWriteHeader((name + "_skeleton.hdr").c_str(), &skeleton_dsr))
+    {
+        std::cerr << "Skeleton header write failed!" << std::endl;
+        return 3;
+    }
+
+    std::vector<unsigned char> slab((std::size_t)sizes.xOy_enlarged_size * (depth + 2));
+    std::vector<char> slices((std::size_t)sizes.xOy_size * (depth + 2));
+
+    /* binary copy of the image, by chunks whose file voxels fit in the size of the slab */
+    const int copy_depth = std::max(1, depth / std::max(1, dsr.dime.bitpix / 8));
+    std::remove(skeleton_filename.c_str());
+    for (int z = 0; z < (int)sizes.size_z; z += copy_depth)
+    {
+        const int d = std::min(copy_depth, (int)sizes.size_z - z);
+        if(anaReadBinaryslices(image_filename.c_str(), &dsr, z, d, &slices[0]) ||
+           anaWriteImageslices(skeleton_filename.c_str(), &skeleton_dsr, z, d, &slices[0]))
+        {
+            std::cerr << "Image data copy failed!" << std::endl;
+            return 4;
+        }
+    }
+
+    Thread_pool* pool = mode != SEQUENTIAL_THINNING ? new Thread_pool(threads) : 0;
+    std::vector<bool> dirty(slabs, true);
+    Sizes sizes_slab;
+    int modified;
+    int result = 0;
+
+    do
+    {
+        modified = 0;
+        for (int k = 0; k < slabs && !result; ++k)
+        {
+            if (!dirty[k])
+            {
+                continue;
+            }
+
+            const int z = k * depth;
+            const int d = std::min(depth, (int)sizes.size_z - z);
+            slab_sizes(sizes, d, sizes_slab);
+
+            if(read_slab(skeleton_filename.c_str(), &skeleton_dsr, sizes, z, d, &slab[0], &slices[0]))
+            {
+                result = 5;
+                break;
+            }
+
+            int deleted;
+            if (mode == PARALLEL_THINNING)
+            {
+                Parallel_thinning thinning(&slab[0], sizes_slab);
+                thinning.seed_all();
+                deleted = thinning.iterate(*pool);
+            }
+            else if (mode == ORDERED_THINNING)
+            {
+                Ordered_thinning thinning(&slab[0], sizes_slab);
+                deleted = thinning.run(*pool);
+            }
+            else if (mode == SPECULATIVE_THINNING)
+            {
+                Thinning thinning(&slab[0], sizes_slab);
+                thinning.seed_all();
+                deleted = thinning.iterate_speculative(*pool);
+            }
+            else
+            {
+                Thinning thinning(&slab[0], sizes_slab);
+                thinning.seed_all();
+                deleted = pool ? thinning.iterate_subfields(*pool) : thinning.iterate();
+            }
+
+            if (deleted)
+            {
+                if(write_slab(skeleton_filename.c_str(), &skeleton_dsr, sizes, z, d, &slab[0], &slices[0]))
+                {
+                    result = 6;
+                    break;
+                }
+
+                // the halo layers of the neighbour slabs changed.
+                if (k > 0)
+                {
+                    dirty[k - 1] = true;
+                }
+                if (k + 1 < slabs)
+                {
+                    dirty[k + 1] = true;
+                }
+            }
+            else
+            {
+                dirty[k] = false;
+            }
+            modified += deleted;
+        }
+
+    } while(modified > 0 && !result);
+
+    delete pool;
+
+    if (result)
+    {
+        std::cerr << "Skeleton slab read or write failed!" << std::endl;
+    }
+
+    return result;
+}
+
+/***********************************************  UTILITIES  definition  ****************************************************/
+/*******************************************************************************
+*   slab_sizes : sizes of a slab of the image, depth layers thick, with its
+*                zero borders in x and y and its halo layers in z.
+*******************************************************************************/
+static void slab_sizes(const Sizes& sizes, int depth, Sizes& slab)
+{
+    slab.size_x = sizes.size_x;
+    slab.size_y = sizes.size_y;
+    slab.size_z = depth;
+    slab.size_x_enlarged = slab.size_x + 2;
+    slab.size_y_enlarged = slab.size_y + 2;
+    slab.size_z_enlarged = slab.size_z + 2;
+    slab.size = slab.size_x * slab.size_y * slab.size_z;
+    slab.size_enlarged = slab.size_x_enlarged * slab.size_y_enlarged * slab.size_z_enlarged;
+    slab.xOy_size = slab.size_x * slab.size_y;
+    slab.xOy_enlarged_size = slab.size_x_enlarged * slab.size_y_enlarged;
+}
+
+/*******************************************************************************
+*   read_slab : read the layers [z - 1, z + depth] of the skeleton file into
+*               the enlarged slab. The layers out of the image stay zero.
+*******************************************************************************/
+static int read_slab(const char* filename, const ANALYZE_DSR* dsr, const Sizes& sizes, int z, int depth,
+                     unsigned char* slab, char* slices)
+{
+    const int first = std::max(z - 1, 0);
+    const int last = std::min(z + depth + 1, (int)sizes.size_z);
+
+    if(anaReadBinaryslices(filename, dsr, first, last - first, slices))
+    {
+        return 1;
+    }
+
+    const int size_x = sizes.size_x_enlarged;
+    memset(slab, 0, (std::size_t)sizes.xOy_enlarged_size * (depth + 2));
+
+    for (int l = first; l < last; ++l)
+    {
+        for (int y = 0; y < (int)sizes.size_y; ++y)
+        {
+            memcpy(slab + (l - z + 1) * sizes.xOy_enlarged_size + (y + 1) * size_x + 1,
+                   slices + (l - first) * sizes.xOy_size + y * sizes.size_x, sizes.size_x);
+        }
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+*   write_slab : write the layers [z, z + depth) of the slab, without their
+*                borders, into the skeleton file.
+*******************************************************************************/
+static int write_slab(const char* filename, const ANALYZE_DSR* dsr, const Sizes& sizes, int z, int depth,
+                      const unsigned char* slab, char* slices)
+{
+    const int size_x = sizes.size_x_enlarged;
+
+    for (int l = 0; l < depth; ++l)
+    {
+        for (int y = 0; y < (int)sizes.size_y; ++y)
+        {
+            memcpy(slices + l * sizes.xOy_size + y * sizes.size_x,
+                   slab + (l + 1) * sizes.xOy_enlarged_size + (y + 1) * size_x + 1, sizes.size_x);
+        }
+    }
+
+    return anaWriteImageslices(filename, dsr, z, depth, slices);
+}
+
+} // end of namespace Trabecula
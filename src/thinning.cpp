@@ -0,0 +1,1252 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides the thinning of a binary image into its
+/*  skeleton, driven by the border points of each direction,
+/*  sequentially or by parallel subfields.
+/*  @implements Thinning.
+/*
+/**********************************************************************/
+
+#include "trabecula/thinning.hpp"
+#include "trabecula/parallel_thinning.hpp"
+#include "trabecula/ordered_thinning.hpp"
+#include "trabecula/simple_tests.hpp"
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <atomic>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace Trabecula
+{
+
+/***********************************************  UTILITIES  declaration  ***************************************************/
+
+// number of voxels of a row tested at once for border points
+#if defined(__AVX2__)
+static const int BORDER_BLOCK = 32;
+#else
+static const int BORDER_BLOCK = 16;
+#endif
+
+static inline unsigned int white_block(const unsigned char* data);
+static inline unsigned long long spread_bits(unsigned long long v);
+static int run_thinning(Thinning& thinning, Thinning_mode mode, unsigned int threads);
+static void thin_image(unsigned char* image, const Sizes& sizes, Thinning_mode mode, unsigned int threads,
+                       Volume_layout layout);
+
+/***********************************************  Thinning  definition  *****************************************************/
+
+const int Thinning::DIRECTION_NEIGHBOURS[6] = { 0, 5, 1, 4, 3, 2 };
+
+// marks of the points of the list queued for the current and the next pass
+static const unsigned char QUEUED = 1;
+static const unsigned char QUEUED_NEXT = 2;
+
+// neighbour of q that p is, when q is the neighbour n of p
+static const unsigned char OPPOSITE_NEIGHBOURS[26] = {
+    5, 4, 3, 2, 1, 0,
+    17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6,
+    25, 24, 23, 22, 21, 20, 19, 18
+                                                      };
+
+// value of a voxel while a thread of a speculative subiteration deletes it
+static const unsigned char TENTATIVE = 2;
+
+// number of candidates of a speculative subiteration given to a task
+static const int SPECULATIVE_CHUNK = 1024;
+
+/* Constructors/Destructors */
+Thinning::Thinning(unsigned char* data, const Sizes& sizes) : mData(data), mSizes(sizes), mBricks(0), mSize(sizes.size_enlarged),
+    mFirst(sizes.xOy_enlarged_size), mLast(sizes.size_enlarged - sizes.xOy_enlarged_size), mLocal(false), mOrder(RASTER_ORDER),
+    mListed(sizes.size_enlarged), mCounters(), mCacheMasks(false)
+{
+    set_directions();
+}
+
+Thinning::Thinning(Brick_volume& bricks) : mData(bricks.data()), mSizes(bricks.sizes()), mBricks(&bricks), mSize(bricks.size()),
+    mFirst(0), mLast(bricks.size()), mLocal(false), mOrder(RASTER_ORDER),
+    mListed(bricks.size()), mCounters(), mCacheMasks(false)
+{
+    set_directions();
+}
+
+/* Setters */
+void Thinning::set_mask_cache(bool enabled)
+{
+    mCacheMasks = enabled;
+}
+
+/*******************************************************************************
+*   set_candidate_order : the order of the candidates (kept on bricks,
+*                         whose storage order is the brick order). The
+*                         border arrays are sorted again in that order.
+*******************************************************************************/
+void Thinning::set_candidate_order(Candidate_order order)
+{
+    mOrder = mBricks ? RASTER_ORDER : order;
+
+    for (int d = 0; d < 6; ++d)
+    {
+        mSorted[d] = 0;
+    }
+}
+
+/* Getters */
+const Thinning_counters& Thinning::counters() const
+{
+    return mCounters;
+}
+
+/* Member Functions */
+/*******************************************************************************
+*   seed_all : fill the border arrays with every border point of the image,
+*              in raster order. On the flat layout the x-rows are tested by
+*              blocks: the border points of a direction are the black voxels
+*              of the block whose shifted block is white.
+*******************************************************************************/
+void Thinning::seed_all()
+{
+    if (mBricks)
+    {
+        for (int i = 0; i < mSize; ++i)
+        {
+            if (mData[i])
+            {
+                for (int d = 0; d < 6; ++d)
+                {
+                    if (!mData[neighbour(i, d)])
+                    {
+                        mBorders[d].push_back(i);
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        const int size_x = mSizes.size_x_enlarged;
+        unsigned int black, border;
+        int row, p, x;
+
+        // the black points are inside the zero borders
+        for (int z = 1; z + 1 < (int)mSizes.size_z_enlarged; ++z)
+        {
+            for (int y = 1; y + 1 < (int)mSizes.size_y_enlarged; ++y)
+            {
+                row = z * mSizes.xOy_enlarged_size + y * size_x;
+
+                for (x = 1; x + BORDER_BLOCK < size_x; x += BORDER_BLOCK)
+                {
+                    p = row + x;
+                    black = ~white_block(mData + p);
+                    if (!black)
+                    {
+                        continue;
+                    }
+
+                    for (int d = 0; d < 6; ++d)
+                    {
+                        border = black & white_block(mData + p + mDirections[d]);
+                        while (border)
+                        {
+                            mBorders[d].push_back(p + first_neighbour(border));
+                            border &= border - 1;
+                        }
+                    }
+                }
+
+                for (p = row + x; p < row + size_x - 1; ++p)
+                {
+                    if (mData[p])
+                    {
+                        for (int d = 0; d < 6; ++d)
+                        {
+                            if (!mData[p + mDirections[d]])
+                            {
+                                mBorders[d].push_back(p);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // the points were found in raster order
+    for (int d = 0; d < 6; ++d)
+    {
+        mSorted[d] = mOrder == RASTER_ORDER ? mBorders[d].size() : 0;
+    }
+}
+
+/*******************************************************************************
+*   seed_around : fill the border arrays with the border points among the
+*                 black neighbours of the changed points. Every other point
+*                 must be left undeletable by the changes, as in an image
+*                 that was thinned before them.
+*******************************************************************************/
+void Thinning::seed_around(const std::vector<int>& changed)
+{
+    mLocal = true;
+
+    for (std::size_t i = 0; i < changed.size(); ++i)
+    {
+        push_borders(changed[i]);
+    }
+
+    for (int d = 0; d < 6; ++d)
+    {
+        mSorted[d] = 0;
+    }
+}
+
+/*******************************************************************************
+*   run : compute the 6 subiterations until no points are deleted, and
+*         return the number of deleted points.
+*******************************************************************************/
+int Thinning::run()
+{
+    return run(Simple_point_table::instance());
+}
+
+template <class Simple_test>
+int Thinning::run(const Simple_test& simple_test)
+{
+    int deleted = 0;
+    int modified;
+
+    do
+    {
+        modified = iterate(simple_test);
+        deleted += modified;
+
+    } while(modified > 0);
+
+    return deleted;
+}
+
+/*******************************************************************************
+*   run_subfields : compute the 6 subiterations, each one split into 8
+*                   parallel subfields, until no points are deleted, and
+*                   return the number of deleted points.
+*******************************************************************************/
+int Thinning::run_subfields(Thread_pool& pool)
+{
+    int deleted = 0;
+    int modified;
+
+    do
+    {
+        modified = iterate_subfields(pool);
+        deleted += modified;
+
+    } while(modified > 0);
+
+    return deleted;
+}
+
+/*******************************************************************************
+*   run_speculative : compute the 6 speculative subiterations until no
+*                     points are deleted, and return the number of deleted
+*                     points.
+*******************************************************************************/
+int Thinning::run_speculative(Thread_pool& pool)
+{
+    int deleted = 0;
+    int modified;
+
+    do
+    {
+        modified = iterate_speculative(pool);
+        deleted += modified;
+
+    } while(modified > 0);
+
+    return deleted;
+}
+
+/*******************************************************************************
+*   iterate : compute the 6 subiterations once, and return the number of
+*             deleted points. The kernels are compiled for the strides of the
+*             common image sizes, and for any strides.
+*******************************************************************************/
+int Thinning::iterate()
+{
+    return iterate(Simple_point_table::instance());
+}
+
+template <class Simple_test>
+int Thinning::iterate(const Simple_test& simple_test)
+{
+    if (!mBricks)
+    {
+        if (Strides_256::matches(mSizes))
+        {
+            return iterate_with<Strides_256>(simple_test);
+        }
+        if (Strides_512::matches(mSizes))
+        {
+            return iterate_with<Strides_512>(simple_test);
+        }
+        if (Strides_1024::matches(mSizes))
+        {
+            return iterate_with<Strides_1024>(simple_test);
+        }
+    }
+    return iterate_with<Runtime_strides>(simple_test);
+}
+
+/*******************************************************************************
+*   iterate_subfields : compute the 6 subiterations once by parallel
+*                       subfields, and return the number of deleted points.
+*******************************************************************************/
+int Thinning::iterate_subfields(Thread_pool& pool)
+{
+    if (!mBricks)
+    {
+        if (Strides_256::matches(mSizes))
+        {
+            return iterate_subfields_with<Strides_256>(pool);
+        }
+        if (Strides_512::matches(mSizes))
+        {
+            return iterate_subfields_with<Strides_512>(pool);
+        }
+        if (Strides_1024::matches(mSizes))
+        {
+            return iterate_subfields_with<Strides_1024>(pool);
+        }
+    }
+    return iterate_subfields_with<Runtime_strides>(pool);
+}
+
+/*******************************************************************************
+*   iterate_speculative : compute the 6 speculative subiterations once, and
+*                         return the number of deleted points.
+*******************************************************************************/
+int Thinning::iterate_speculative(Thread_pool& pool)
+{
+    int modified = 0;
+
+    for (int d = 0; d < 6; ++d)
+    {
+        modified += speculative_subiter(d, pool);
+    }
+
+    return modified;
+}
+
+template <class Strides, class Simple_test>
+int Thinning::iterate_with(const Simple_test& simple_test)
+{
+    int modified = 0;
+
+    for (int d = 0; d < 6; ++d)
+    {
+        modified += subiter<Strides>(d, simple_test);
+    }
+
+    return modified;
+}
+
+template <class Strides>
+int Thinning::iterate_subfields_with(Thread_pool& pool)
+{
+    int modified = 0;
+
+    for (int d = 0; d < 6; ++d)
+    {
+        modified += subfield_subiter<Strides>(d, pool);
+    }
+
+    return modified;
+}
+
+/*******************************************************************************
+*   subiter : Return the number of deleted points in the subiteration from
+*             a particular direction. The candidates are the border points
+*             of that direction, visited in the candidate order. The
+*             simple and non end points among them are deleted by passes
+*             in that order, until a pass deletes nothing. A point kept by
+*             a pass is only checked again once one of its neighbours is
+*             deleted: its neighbourhood is the same otherwise.
+*******************************************************************************/
+template <class Strides, class Simple_test>
+int Thinning::subiter(int direction, const Simple_test& simple_points)
+{
+    Basic_neighbourhood_scanner<Strides> scanner(mData, mSizes);
+    std::vector<int>& border = mBorders[direction];
+    int modified = 0;
+    unsigned int mask;
+
+    sort_borders(direction);
+
+    /* list of simple and non end points, in the candidate order, their codes */
+    /* in Morton order, and their masks                                       */
+    std::vector<int>& list = mList;
+    list.clear();
+    mListKeys.clear();
+    mMasks.clear();
+
+    // fill the list in a first check loop.
+    for (std::size_t i = 0; i < border.size(); ++i)
+    {
+        mask = this->mask(scanner, border[i]);
+
+        if( count_neighbours(mask) > 1 && simple_points.is_simple(mask) )
+        {
+            list.push_back(border[i]);
+            mListed.set(border[i]);
+            if (mOrder == MORTON_ORDER)
+            {
+                mListKeys.push_back(mBorderKeys[direction][i]);
+            }
+            if (mCacheMasks)
+            {
+                mMasks.push_back(mask);
+            }
+        }
+    }
+
+    /* the first pass checks the whole list, the next ones their queued points, */
+    /* in order: the sorted queue of the pass, and the heap of the points queued */
+    /* during the pass                                                           */
+    std::vector<int>& queued = mQueued;
+    std::vector<int>& late = mLate;
+    std::vector<int>& next = mNext;
+    queued.resize(list.size());
+    late.clear();
+    next.clear();
+    mMarks.assign(list.size(), QUEUED);
+    for (std::size_t i = 0; i < list.size(); ++i)
+    {
+        queued[i] = i;
+    }
+
+    std::size_t remaining = list.size();
+    bool first_pass = true;
+    int pass_modified;
+    int i;
+
+    // remove each point of the list if they remain simple and non endpoint.
+    do
+    {
+        const std::size_t pass_remaining = remaining;
+        std::size_t pass_checks = 0;
+        std::size_t k = 0;
+        pass_modified = 0;
+        scanner.reset();
+
+        while (k < queued.size() || !late.empty())
+        {
+            if (!late.empty() && (k == queued.size() || late.front() < queued[k]))
+            {
+                std::pop_heap(late.begin(), late.end(), std::greater<int>());
+                i = late.back();
+                late.pop_back();
+            }
+            else
+            {
+                i = queued[k++];
+            }
+            mMarks[i] &= ~QUEUED;
+            ++pass_checks;
+
+            mask = mCacheMasks ? mMasks[i] : this->mask(scanner, list[i]);
+
+            if( count_neighbours(mask) > 1 && simple_points.is_simple(mask) )
+            {
+                erase(list[i]);
+                scanner.reset();
+                ++pass_modified;
+                --remaining;
+
+                queue_neighbours(list, i, mask, first_pass);
+                if (mCacheMasks)
+                {
+                    uncache_neighbours(list, i, mask);
+                }
+            }
+        }
+
+        mCounters.checks += pass_checks;
+        mCounters.avoided_checks += pass_remaining - pass_checks;
+        modified += pass_modified;
+
+        std::sort(next.begin(), next.end());
+        for (std::size_t n = 0; n < next.size(); ++n)
+        {
+            mMarks[next[n]] = QUEUED;
+        }
+        queued.swap(next);
+        next.clear();
+        first_pass = false;
+
+    } while( pass_modified > 0 );
+
+    for (std::size_t i = 0; i < list.size(); ++i)
+    {
+        mListed.reset(list[i]);
+    }
+
+    return modified;
+}
+
+/*******************************************************************************
+*   queue_neighbours : queue the points of the list that are black
+*                      neighbours (given by mask) of the deleted point
+*                      list[i]: in the current pass if they come after it,
+*                      in the next one otherwise. In the first pass, the
+*                      points after list[i] are all queued already.
+*******************************************************************************/
+void Thinning::queue_neighbours(const std::vector<int>& list, int i, unsigned int mask, bool first_pass)
+{
+    int q, j;
+
+    if (first_pass && mOrder == RASTER_ORDER)
+    {
+        mask &= mPreceding;
+    }
+
+    for (; mask; mask &= mask - 1)
+    {
+        q = neighbour_26(list[i], first_neighbour(mask));
+        if (!mListed.test(q) || (first_pass && follows(list, i, q)))
+        {
+            continue;
+        }
+
+        j = list_index(list, i, q);
+        if (j > i && !(mMarks[j] & QUEUED))
+        {
+            mMarks[j] |= QUEUED;
+            mLate.push_back(j);
+            std::push_heap(mLate.begin(), mLate.end(), std::greater<int>());
+        }
+        else if (j < i && !(mMarks[j] & QUEUED_NEXT))
+        {
+            mMarks[j] |= QUEUED_NEXT;
+            mNext.push_back(j);
+        }
+    }
+}
+
+/*******************************************************************************
+*   uncache_neighbours : clear the bit of the deleted point list[i] in the
+*                        cached masks of its black neighbours (given by
+*                        mask) of the list. The neighbour n of list[i] sees
+*                        it as its neighbour opposite to n.
+*******************************************************************************/
+void Thinning::uncache_neighbours(const std::vector<int>& list, int i, unsigned int mask)
+{
+    const int p = list[i];
+    int n, q;
+
+    for (; mask; mask &= mask - 1)
+    {
+        n = first_neighbour(mask);
+        q = neighbour_26(p, n);
+        if (!mListed.test(q))
+        {
+            continue;
+        }
+
+        mMasks[list_index(list, i, q)] &= ~(1u << OPPOSITE_NEIGHBOURS[n]);
+    }
+}
+
+/*******************************************************************************
+*   list_index : Return the index in the list of its point q, a neighbour of
+*                list[i]. In raster order, the list being strictly
+*                increasing, q is at most |q - list[i]| places away from i.
+*                In Morton order, q is searched by its code, in ranges
+*                doubling away from i: it is most often a few places away.
+*******************************************************************************/
+int Thinning::list_index(const std::vector<int>& list, int i, int q) const
+{
+    if (mOrder == MORTON_ORDER)
+    {
+        const unsigned long long key = morton_key(q);
+        const int size = mListKeys.size();
+        int low, high, step;
+
+        if (key > mListKeys[i])
+        {
+            low = i;
+            for (step = 1; i + step < size && mListKeys[i + step] < key; step *= 2)
+            {
+                low = i + step;
+            }
+            high = std::min(i + step, size);
+        }
+        else
+        {
+            high = i;
+            for (step = 1; i - step >= 0 && mListKeys[i - step] > key; step *= 2)
+            {
+                high = i - step;
+            }
+            low = std::max(i - step, 0);
+        }
+        return std::lower_bound(mListKeys.begin() + low, mListKeys.begin() + high, key) - mListKeys.begin();
+    }
+
+    const int p = list[i];
+    std::vector<int>::const_iterator first, last;
+
+    if (q > p)
+    {
+        first = list.begin() + i + 1;
+        last = list.begin() + std::min<std::size_t>(list.size(), (std::size_t)i + 1 + (q - p));
+    }
+    else
+    {
+        first = list.begin() + std::max(0, i - (p - q));
+        last = list.begin() + i;
+    }
+    return std::lower_bound(first, last, q) - list.begin();
+}
+
+/*******************************************************************************
+*   follows : Return true when the neighbour q of list[i] comes after it in
+*             the candidate order.
+*******************************************************************************/
+bool Thinning::follows(const std::vector<int>& list, int i, int q) const
+{
+    return mOrder == MORTON_ORDER ? morton_key(q) > mListKeys[i] : q > list[i];
+}
+
+/*******************************************************************************
+*   morton_key : Return the Morton code of the flat point p, its coordinates
+*                interleaved bit by bit (x lowest).
+*******************************************************************************/
+unsigned long long Thinning::morton_key(int p) const
+{
+    const int z = p / mSizes.xOy_enlarged_size;
+    const int r = p - z * mSizes.xOy_enlarged_size;
+    const int y = r / mSizes.size_x_enlarged;
+    const int x = r - y * mSizes.size_x_enlarged;
+
+    return spread_bits(x) | spread_bits(y) << 1 | spread_bits(z) << 2;
+}
+
+/*******************************************************************************
+*   subfield_subiter : Return the number of deleted points in the
+*             subiteration from a particular direction. The border points
+*             of each parity class are tested in parallel on the image left
+*             by the previous class, then deleted in raster order, so that
+*             the result does not depend on the number of threads.
+*******************************************************************************/
+template <class Strides>
+int Thinning::subfield_subiter(int direction, Thread_pool& pool)
+{
+    const Simple_point_table& simple_points = Simple_point_table::instance();
+    std::vector<int>& border = mBorders[direction];
+    int modified = 0;
+
+    sort_borders(direction);
+
+    for (int k = 0; k < 8; ++k)
+    {
+        mSubfields[k].clear();
+    }
+    for (std::size_t i = 0; i < border.size(); ++i)
+    {
+        mSubfields[parity(border[i])].push_back(border[i]);
+    }
+
+    for (int k = 0; k < 8; ++k)
+    {
+        const std::vector<int>& subfield = mSubfields[k];
+        const int chunk = 1024;
+        const int tasks = (subfield.size() + chunk - 1) / chunk;
+
+        if (mDeletable.size() < (std::size_t)tasks)
+        {
+            mDeletable.resize(tasks);
+        }
+
+        pool.run(tasks, [&](int t)
+        {
+            Basic_neighbourhood_scanner<Strides> scanner(mData, mSizes);
+            std::vector<int>& deletable = mDeletable[t];
+            const std::size_t end = std::min(subfield.size(), (std::size_t)(t + 1) * chunk);
+            unsigned int mask;
+
+            deletable.clear();
+            for (std::size_t i = (std::size_t)t * chunk; i < end; ++i)
+            {
+                mask = this->mask(scanner, subfield[i]);
+
+                if( count_neighbours(mask) > 1 && simple_points.is_simple(mask) )
+                {
+                    deletable.push_back(subfield[i]);
+                }
+            }
+        });
+
+        for (int t = 0; t < tasks; ++t)
+        {
+            for (std::size_t i = 0; i < mDeletable[t].size(); ++i)
+            {
+                erase(mDeletable[t][i]);
+                ++modified;
+            }
+        }
+    }
+
+    return modified;
+}
+
+/*******************************************************************************
+*   speculative_subiter : Return the number of deleted points in the
+*             subiteration from a particular direction. The candidates are
+*             the simple and non end border points, as in subiter. Each task
+*             deletes the ones of its chunk that stay so, in raster order,
+*             on the image shared with the other tasks: a point that looks
+*             deletable is marked TENTATIVE, then its neighbourhood is read
+*             again after a full fence. When a neighbour is TENTATIVE too,
+*             the deletion is rolled back, else it is decided on that
+*             neighbourhood. Two neighbours marked at
+*             once cannot both miss the mark of the other, so every deletion
+*             is checked on the deletions made before it. A point seeing a
+*             TENTATIVE neighbour at first is skipped, as a conflict too.
+*             The passes are repeated on the remaining points until one
+*             deletes nothing; when a pass only has conflicts, a serial one
+*             follows.
+*******************************************************************************/
+int Thinning::speculative_subiter(int direction, Thread_pool& pool)
+{
+    const Simple_point_table& simple_points = Simple_point_table::instance();
+    std::vector<int>& list = mList;
+    int modified = 0;
+    int pass_modified;
+
+    sort_borders(direction);
+
+    /* list of simple and non end points, in raster order, found in parallel */
+    const std::vector<int>& border = mBorders[direction];
+    const int border_tasks = (border.size() + SPECULATIVE_CHUNK - 1) / SPECULATIVE_CHUNK;
+    if (mDeletable.size() < (std::size_t)border_tasks)
+    {
+        mDeletable.resize(border_tasks);
+    }
+
+    pool.run(border_tasks, [&](int t)
+    {
+        Neighbourhood_scanner scanner(mData, mSizes);
+        std::vector<int>& candidates = mDeletable[t];
+        const std::size_t end = std::min(border.size(), (std::size_t)(t + 1) * SPECULATIVE_CHUNK);
+        unsigned int mask;
+
+        candidates.clear();
+        for (std::size_t i = (std::size_t)t * SPECULATIVE_CHUNK; i < end; ++i)
+        {
+            mask = this->mask(scanner, border[i]);
+            if( count_neighbours(mask) > 1 && simple_points.is_simple(mask) )
+            {
+                candidates.push_back(border[i]);
+            }
+        }
+    });
+
+    list.clear();
+    for (int t = 0; t < border_tasks; ++t)
+    {
+        list.insert(list.end(), mDeletable[t].begin(), mDeletable[t].end());
+    }
+
+    do
+    {
+        const int tasks = (list.size() + SPECULATIVE_CHUNK - 1) / SPECULATIVE_CHUNK;
+        std::atomic<unsigned long> conflicts(0);
+
+        if (mDeletable.size() < (std::size_t)tasks)
+        {
+            mDeletable.resize(tasks);
+        }
+
+        pool.run(tasks, [&](int t)
+        {
+            std::vector<int>& deleted = mDeletable[t];
+            const std::size_t end = std::min(list.size(), (std::size_t)(t + 1) * SPECULATIVE_CHUNK);
+            unsigned long task_conflicts = 0;
+            unsigned int mask;
+            bool conflict;
+            int p;
+
+            deleted.clear();
+            for (std::size_t i = (std::size_t)t * SPECULATIVE_CHUNK; i < end; ++i)
+            {
+                p = list[i];
+                mask = speculative_mask(p, conflict);
+                if (conflict)
+                {
+                    ++task_conflicts;
+                    continue;
+                }
+                if( count_neighbours(mask) <= 1 || !simple_points.is_simple(mask) )
+                {
+                    continue;
+                }
+
+                __atomic_store_n(mData + p, TENTATIVE, __ATOMIC_RELAXED);
+                __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+                mask = speculative_mask(p, conflict);
+                if (conflict)
+                {
+                    __atomic_store_n(mData + p, 1, __ATOMIC_RELAXED);
+                    ++task_conflicts;
+                }
+                else if( count_neighbours(mask) > 1 && simple_points.is_simple(mask) )
+                {
+                    __atomic_store_n(mData + p, 0, __ATOMIC_RELAXED);
+                    deleted.push_back(p);
+                }
+                else
+                {
+                    __atomic_store_n(mData + p, 1, __ATOMIC_RELAXED);
+                }
+            }
+            conflicts += task_conflicts;
+        });
+
+        pass_modified = 0;
+        for (int t = 0; t < tasks; ++t)
+        {
+            for (std::size_t i = 0; i < mDeletable[t].size(); ++i)
+            {
+                erase(mDeletable[t][i]);
+                ++pass_modified;
+            }
+        }
+        mCounters.speculative_deletions += pass_modified;
+        mCounters.conflicts += conflicts;
+
+        // the conflicting points are checked again, alone.
+        if (pass_modified == 0 && conflicts > 0)
+        {
+            Neighbourhood_scanner scanner(mData, mSizes);
+            unsigned int mask;
+
+            for (std::size_t i = 0; i < list.size(); ++i)
+            {
+                mask = this->mask(scanner, list[i]);
+                if( mData[list[i]] && count_neighbours(mask) > 1 && simple_points.is_simple(mask) )
+                {
+                    erase(list[i]);
+                    scanner.reset();
+                    ++pass_modified;
+                }
+            }
+            mCounters.serial_deletions += pass_modified;
+        }
+        modified += pass_modified;
+
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < list.size(); ++i)
+        {
+            if (mData[list[i]])
+            {
+                list[kept++] = list[i];
+            }
+        }
+        list.resize(kept);
+
+    } while( pass_modified > 0 );
+
+    return modified;
+}
+
+/*******************************************************************************
+*   speculative_mask : neighbourhood mask of p read on an image that other
+*                      threads modify, and whether one of its neighbours is
+*                      being deleted.
+*******************************************************************************/
+unsigned int Thinning::speculative_mask(int p, bool& conflict) const
+{
+    unsigned int mask = 0;
+    unsigned char value;
+
+    conflict = false;
+    for (int n = 0; n < 26; ++n)
+    {
+        value = __atomic_load_n(mData + neighbour_26(p, n), __ATOMIC_RELAXED);
+        mask |= (unsigned int)(value != 0) << n;
+        conflict |= value == TENTATIVE;
+    }
+
+    return mask;
+}
+
+/*******************************************************************************
+*   parity : Return the subfield (0 to 7) of the point p, from the parity of
+*            its 3 coordinates.
+*******************************************************************************/
+int Thinning::parity(int p) const
+{
+    if (mBricks)
+    {
+        // the bricks start on even coordinates
+        return (p & 1) | (p >> 3 & 1) << 1 | (p >> 6 & 1) << 2;
+    }
+
+    const int z = p / mSizes.xOy_enlarged_size;
+    const int r = p - z * mSizes.xOy_enlarged_size;
+    const int y = r / mSizes.size_x_enlarged;
+    const int x = r - y * mSizes.size_x_enlarged;
+
+    return (x & 1) | (y & 1) << 1 | (z & 1) << 2;
+}
+
+/*******************************************************************************
+*   set_directions : initialize the flat offsets of the 6 directions.
+*******************************************************************************/
+void Thinning::set_directions()
+{
+    mDirections[0] = -mSizes.size_x_enlarged;     // Up
+    mDirections[1] = mSizes.size_x_enlarged;      // Down
+    mDirections[2] = mSizes.xOy_enlarged_size;    // North
+    mDirections[3] = -mSizes.xOy_enlarged_size;   // South
+    mDirections[4] = 1;                           // East
+    mDirections[5] = -1;                          // West
+
+    collect_26_neighbours(0, mSizes, mOffsets);
+
+    // in bricks, the order of a neighbour depends on the position of the point
+    mPreceding = 0;
+    for (int n = 0; n < 26; ++n)
+    {
+        if (mBricks || mOffsets[n] < 0)
+        {
+            mPreceding |= 1u << n;
+        }
+    }
+
+    for (int d = 0; d < 6; ++d)
+    {
+        mSorted[d] = 0;
+    }
+}
+
+/*******************************************************************************
+*   sort_borders : drop the deleted points from the border points of a
+*                  direction, and merge the new ones in the candidate order,
+*                  without duplicates. In Morton order, the points are
+*                  sorted with their codes, kept for the sorted ones.
+*******************************************************************************/
+void Thinning::sort_borders(int direction)
+{
+    std::vector<int>& border = mBorders[direction];
+    std::vector<unsigned long long>& border_keys = mBorderKeys[direction];
+    std::size_t kept = 0;
+    std::size_t sorted = 0;
+
+    for (std::size_t i = 0; i < border.size(); ++i)
+    {
+        if (mData[border[i]])
+        {
+            if (i < mSorted[direction])
+            {
+                if (mOrder == MORTON_ORDER)
+                {
+                    border_keys[sorted] = border_keys[i];
+                }
+                ++sorted;
+            }
+            border[kept++] = border[i];
+        }
+    }
+    border.resize(kept);
+
+    if (mOrder == MORTON_ORDER)
+    {
+        std::vector<std::pair<unsigned long long, int> >& keys = mSortKeys;
+        keys.resize(border.size());
+        for (std::size_t i = 0; i < sorted; ++i)
+        {
+            keys[i] = std::make_pair(border_keys[i], border[i]);
+        }
+        for (std::size_t i = sorted; i < border.size(); ++i)
+        {
+            keys[i] = std::make_pair(morton_key(border[i]), border[i]);
+        }
+
+        std::sort(keys.begin() + sorted, keys.end());
+        std::inplace_merge(keys.begin(), keys.begin() + sorted, keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+        border.resize(keys.size());
+        border_keys.resize(keys.size());
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            border_keys[i] = keys[i].first;
+            border[i] = keys[i].second;
+        }
+    }
+    else
+    {
+        std::sort(border.begin() + sorted, border.end());
+        std::inplace_merge(border.begin(), border.begin() + sorted, border.end());
+        border.erase(std::unique(border.begin(), border.end()), border.end());
+    }
+    mSorted[direction] = border.size();
+}
+
+/*******************************************************************************
+*   erase : delete the point p. Each black point whose neighbour in a
+*           direction is p becomes a border point of that direction
+*           (it was not one before, since p was black), unless it lies
+*           out of the deletable points.
+*******************************************************************************/
+void Thinning::erase(int p)
+{
+    mData[p] = 0;
+
+    if (mLocal)
+    {
+        push_borders(p);
+        return;
+    }
+
+    int q;
+    for (int d = 0; d < 6; ++d)
+    {
+        q = neighbour(p, d ^ 1);
+        if (mData[q] && q >= mFirst && q < mLast)
+        {
+            mBorders[d].push_back(q);
+        }
+    }
+}
+
+/*******************************************************************************
+*   push_borders : push each black neighbour of p into the border arrays of
+*                  the directions it is a border point of.
+*******************************************************************************/
+void Thinning::push_borders(int p)
+{
+    int q;
+    for (int n = 0; n < 26; ++n)
+    {
+        q = neighbour_26(p, n);
+        if (mData[q] && q >= mFirst && q < mLast)
+        {
+            for (int d = 0; d < 6; ++d)
+            {
+                if (!mData[neighbour(q, d)])
+                {
+                    mBorders[d].push_back(q);
+                }
+            }
+        }
+    }
+}
+
+/***********************************************  UTILITIES  definition  ****************************************************/
+/*******************************************************************************
+*   white_block : Return a mask whose bit i is set when data[i] is white,
+*                 for i in [0, BORDER_BLOCK).
+*******************************************************************************/
+static inline unsigned int white_block(const unsigned char* data)
+{
+#if defined(__AVX2__)
+    const __m256i voxels = _mm256_loadu_si256((const __m256i*)data);
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi8(voxels, _mm256_setzero_si256()));
+#elif defined(__SSE2__)
+    const __m128i voxels = _mm_loadu_si128((const __m128i*)data);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(voxels, _mm_setzero_si128()));
+#else
+    unsigned int white = 0;
+    for (int i = 0; i < BORDER_BLOCK; ++i)
+    {
+        white |= (unsigned int)(data[i] == 0) << i;
+    }
+    return white;
+#endif
+}
+
+/*******************************************************************************
+*   spread_bits : Return v (21 bits) with two zero bits inserted after each
+*                 of its bits.
+*******************************************************************************/
+static inline unsigned long long spread_bits(unsigned long long v)
+{
+    v &= 0x1FFFFF;
+    v = (v | v << 32) & 0x1F00000000FFFFull;
+    v = (v | v << 16) & 0x1F0000FF0000FFull;
+    v = (v | v << 8) & 0x100F00F00F00F00Full;
+    v = (v | v << 4) & 0x10C30C30C30C30C3ull;
+    v = (v | v << 2) & 0x1249249249249249ull;
+    return v;
+}
+
+/*******************************************************************************
+*   run_thinning : run a seeded thinning in the given mode.
+*******************************************************************************/
+static int run_thinning(Thinning& thinning, Thinning_mode mode, unsigned int threads)
+{
+    if (mode == SUBFIELD_THINNING)
+    {
+        Thread_pool pool(threads);
+        return thinning.run_subfields(pool);
+    }
+    if (mode == SPECULATIVE_THINNING)
+    {
+        Thread_pool pool(threads);
+        return thinning.run_speculative(pool);
+    }
+    return thinning.run();
+}
+
+/*******************************************************************************
+*   thin_image : thin in place a binary image (0 or 1) with zero borders.
+*                The parallel and ordered modes always thin the flat image.
+*******************************************************************************/
+static void thin_image(unsigned char* image, const Sizes& sizes, Thinning_mode mode, unsigned int threads,
+                       Volume_layout layout)
+{
+    if (mode == PARALLEL_THINNING)
+    {
+        Thread_pool pool(threads);
+        Parallel_thinning thinning(image, sizes);
+        thinning.seed_all();
+        thinning.run(pool);
+    }
+    else if (mode == ORDERED_THINNING)
+    {
+        Thread_pool pool(threads);
+        Ordered_thinning thinning(image, sizes);
+        thinning.run(pool);
+    }
+    else if (layout == BRICK_LAYOUT)
+    {
+        Brick_volume bricks(image, sizes);
+        Thinning thinning(bricks);
+        thinning.seed_all();
+        run_thinning(thinning, mode, threads);
+        bricks.to_flat(image);
+    }
+    else
+    {
+        Thinning thinning(image, sizes);
+        thinning.seed_all();
+        run_thinning(thinning, mode, threads);
+    }
+}
+
+/******************************************************************************************
+* Skeletonize_data : this function computes a skeleton of 3D image data and store
+* its result in the skeleton data structure.
+* Implementation of : A sequential 3D thinning algorithm and its medical applications (2001)
+******************************************************************************************/
+int skeletonize_data(const unsigned char* data, unsigned char* skeleton, const Sizes& sizes,
+                     Thinning_mode mode, unsigned int threads, Volume_layout layout)
+{
+    if(!data)
+    {
+        std::cerr << "error, no data to skeletonize!" << std::endl;
+        return 1;
+    }
+
+    /*  create a copy of data with binary values and zero borders */
+    unsigned char *data_tmp = new unsigned char[sizes.size_enlarged];
+    for (int i = 0; i < sizes.size_enlarged; ++i)
+    {
+        data_tmp[i] = data[i] != 0;
+    }
+
+    thin_image(data_tmp, sizes, mode, threads, layout);
+
+    /* copy the result into the skeleton data */
+    memcpy(skeleton, data_tmp, sizes.size_enlarged * sizeof(unsigned char));
+
+    delete [] data_tmp;
+
+    return 0;
+}
+
+/******************************************************************************************
+* Skeletonize_data : same on packed images. The thinning itself works on one byte
+* per voxel, only for its duration.
+******************************************************************************************/
+int skeletonize_data(const Bit_volume& data, Bit_volume& skeleton, const Sizes& sizes,
+                     Thinning_mode mode, unsigned int threads, Volume_layout layout)
+{
+    if(data.empty())
+    {
+        std::cerr << "error, no data to skeletonize!" << std::endl;
+        return 1;
+    }
+
+    unsigned char *data_tmp = new unsigned char[sizes.size_enlarged];
+    data.unpack(data_tmp);
+
+    thin_image(data_tmp, sizes, mode, threads, layout);
+
+    if (skeleton.size() != sizes.size_enlarged)
+    {
+        skeleton.resize(sizes.size_enlarged);
+    }
+    skeleton.pack(data_tmp);
+
+    delete [] data_tmp;
+
+    return 0;
+}
+
+/******************************************************************************************
+* Rethin_data : the points that may become deletable are around the removed ones, so the
+* thinning starts from them. It visits them in the same order as the full thinning would.
+******************************************************************************************/
+void rethin_data(unsigned char* skeleton, const Sizes& sizes, const std::vector<int>& removed,
+                 Volume_layout layout)
+{
+    if (layout == BRICK_LAYOUT)
+    {
+        Brick_volume bricks(skeleton, sizes);
+        std::vector<int> changed(removed.size());
+        for (std::size_t i = 0; i < removed.size(); ++i)
+        {
+            changed[i] = bricks.storage(removed[i]);
+        }
+
+        Thinning thinning(bricks);
+        thinning.seed_around(changed);
+        thinning.run();
+        bricks.to_flat(skeleton);
+    }
+    else
+    {
+        Thinning thinning(skeleton, sizes);
+        thinning.seed_around(removed);
+        thinning.run();
+    }
+}
+
+/* simple point tests of the sequential thinning */
+template int Thinning::run(const Simple_point_table& simple_test);
+template int Thinning::run(const Recursive_simple_test& simple_test);
+template int Thinning::run(const Euler_simple_test& simple_test);
+template int Thinning::run(const Decision_tree_simple_test& simple_test);
+template int Thinning::iterate(const Simple_point_table& simple_test);
+template int Thinning::iterate(const Recursive_simple_test& simple_test);
+template int Thinning::iterate(const Euler_simple_test& simple_test);
+template int Thinning::iterate(const Decision_tree_simple_test& simple_test);
+
+} // end of namespace Trabecula
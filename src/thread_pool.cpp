@@ -0,0 +1,149 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides a minimal pool of worker threads running
+/*  indexed tasks.
+/*  @implements Thread_pool.
+/*
+/**********************************************************************/
+
+#include "trabecula/thread_pool.hpp"
+
+namespace Trabecula
+{
+
+/***********************************************  Thread_pool  definition  **************************************************/
+
+/* Constructors/Destructors */
+Thread_pool::Thread_pool(unsigned int threads) : mTask(0), mTasks(0), mNext(0), mBusy(0), mGeneration(0), mStop(false)
+{
+    if (threads == 0)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0)
+    {
+        threads = 1;
+    }
+
+    // the calling thread is the first worker.
+    for (unsigned int i = 1; i < threads; ++i)
+    {
+        mThreads.push_back(std::thread(&Thread_pool::work, this));
+    }
+}
+
+Thread_pool::~Thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mStart.notify_all();
+
+    for (std::size_t i = 0; i < mThreads.size(); ++i)
+    {
+        mThreads[i].join();
+    }
+}
+
+/* Getters */
+unsigned int Thread_pool::size() const
+{
+    return mThreads.size() + 1;
+}
+
+/* Member Functions */
+/*******************************************************************************
+*   run : call task(i) for each i in [0, tasks) on the threads of the pool.
+*         The tasks are handed out in increasing order, and the function
+*         returns once all of them are done.
+*******************************************************************************/
+void Thread_pool::run(int tasks, const std::function<void(int)>& task)
+{
+    if (tasks <= 0)
+    {
+        return;
+    }
+
+    if (mThreads.empty() || tasks == 1)
+    {
+        for (int i = 0; i < tasks; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTask = &task;
+        mTasks = tasks;
+        mNext = 0;
+        mBusy = mThreads.size();
+        ++mGeneration;
+    }
+    mStart.notify_all();
+
+    execute();
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (mBusy > 0)
+    {
+        mDone.wait(lock);
+    }
+    mTask = 0;
+}
+
+/*******************************************************************************
+*   work : loop of a worker thread, waiting for the next run() call.
+*******************************************************************************/
+void Thread_pool::work()
+{
+    unsigned long generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (!mStop && mGeneration == generation)
+            {
+                mStart.wait(lock);
+            }
+            if (mStop)
+            {
+                return;
+            }
+            generation = mGeneration;
+        }
+
+        execute();
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (--mBusy == 0)
+        {
+            mDone.notify_one();
+        }
+    }
+}
+
+/*******************************************************************************
+*   execute : take and run the remaining tasks of the current run() call.
+*******************************************************************************/
+void Thread_pool::execute()
+{
+    int i;
+    while ((i = mNext++) < mTasks)
+    {
+        (*mTask)(i);
+    }
+}
+
+} // end of namespace Trabecula
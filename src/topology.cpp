@@ -0,0 +1,578 @@
+/**********************************************************************/
+/*  Copyright (c) 2014, Jerome Bouzillard
+/*  All rights reserved.
+/*
+/*  Redistribution and use in source and binary forms, with or without
+/*  modification, are permitted as soon as it retains the above copyright
+/*  notice.
+*********************************************************************/
+/**********************************************************************/
+/*
+/* This file provides the topological tests of the thinning process :
+/*  the recursive reference implementation of the simple point test,
+/*  the table answering it for every 26-neighbourhood configuration,
+/*  and the tables extracting the neighbourhoods as bit masks
+/*  (Basic_neighbourhood_scanner is a template of topology.hpp).
+/*  @implements Simple_point_table.
+/*
+/**********************************************************************/
+
+#include "trabecula/topology.hpp"
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <bitset>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace Trabecula
+{
+
+/***********************************************  UTILITIES  declaration  ***************************************************/
+
+/* This constant provides all the 26-adjacent neighbours of each of the 26 neighbours of a point */
+static const unsigned short S26[171] = {
+    1, 2, 3, 4, 6, 7, 8, 9, 10, 11, 12, 13, 18, 19, 20, 21    //    U
+  , 2, 3, 5, 6, 7, 8, 10, 11, 14, 15, 16, 18, 19, 22, 23      //     N
+  , 4, 5, 6, 7, 9, 10, 12, 14, 15, 17, 18, 20, 22, 24         // W
+  , 4, 5, 6, 8, 9, 11, 13, 14, 16, 17, 19, 21, 23, 25         // E
+  , 3, 5, 7, 8, 9, 12, 13, 15, 16, 17, 20, 21, 24, 25         //     S
+  , 3, 4, 10, 11, 12, 13, 14, 15, 16, 17, 22, 23, 24, 25      //   D
+
+  , 3, 7, 8, 10, 11, 18, 19                                   //   U N
+  , 4, 6, 9, 10, 12, 18, 20                                   // W U
+  , 4, 6, 9, 11, 13, 19, 21                                   // E U
+  , 3, 7, 8, 12, 13, 20, 21                                   //   U S
+  , 5, 6, 7, 14, 15, 18, 22                                   // W   N
+  , 5, 6, 8, 14, 16, 19, 23                                   // E   N
+  , 5, 7, 9, 15, 17, 20, 24                                   // W   S
+  , 5, 8, 9, 16, 17, 21, 25                                   // E   S
+  , 3, 10, 11, 15, 16, 22, 23                                 //   D N
+  , 4, 10, 12, 14, 17, 22, 24                                 // W D
+  , 4, 11, 13, 14, 17, 23, 25                                 // E D
+  , 3, 12, 13, 15, 16, 24, 25                                 //   D S
+
+                                                              // W U N
+                                                              // E U N
+                                                              // W U S
+                                                              // E U S
+                                                              // W D N
+                                                              // E D N
+                                                              // W D S
+                                                              // E D S
+                                        };
+
+/* This constant provides the 6-adjacent neighbours of the 18 neighbours of a point */
+static const unsigned short S6_18[48] = {
+   6, 7, 8, 9        //    U
+ , 6, 10, 11, 14     //     N
+ , 7, 10, 12, 15     // W
+ , 8, 11, 13, 16     // E
+ , 9, 12, 13, 17     //     S
+ , 14, 15, 16, 17    //   D
+ , 1, 0              //   U N
+ , 2, 0              // W U
+ , 3, 0              // E U
+ , 4, 0              //   U S
+ , 2, 1              // W   N
+ , 3, 1              // E   N
+ , 4, 2              // W   S
+ , 3, 4              // E   S
+ , 1, 5              //   D N
+ , 2, 5              // W D
+ , 3, 5              // E D
+ , 4, 5              //   D S
+
+                    // W U N
+                    // E U N
+                    // W U S
+                    // E U S
+                    // W D N
+                    // E D N
+                    // W D S
+                    // E D S
+                                        };
+
+
+static const unsigned short INDICESS26[27] = {0, 16, 31, 45, 59, 73, 87, 94, 101, 108, 115, 122, 129, 136, 143, 150, 157, 164, 171, 171, 171, 171, 171, 171, 171, 171, 171};
+static const unsigned short INDICESS6_18[19] = {0, 4, 8, 12, 16, 20, 24, 26, 28, 30, 32, 34, 36, 38, 40, 42, 44, 46, 48};
+
+/* Position of each neighbour in a 3x3x3 cube, bit x + 3*y + 9*z (W->E, U->D, S->N) */
+static const unsigned char CUBE_BITS[26] = {
+    10, 22, 12, 14, 4, 16                                         // U N W E S D
+  , 19, 9, 11, 1, 21, 23, 3, 5, 25, 15, 17, 7                     // UN WU EU US WN EN WS ES DN WD ED DS
+  , 18, 20, 0, 2, 24, 26, 6, 8                                    // WUN EUN WUS EUS WDN EDN WDS EDS
+                                        };
+
+static const unsigned int CUBE_CENTER = 1u << 13;
+static const unsigned int CUBE_FULL = (1u << 27) - 1;
+static const unsigned int CUBE_X0 = 0x1249249;   // x == 0
+static const unsigned int CUBE_X2 = 0x4924924;   // x == 2, as in Basic_neighbourhood_scanner
+static const unsigned int CUBE_Y0 = 0x01C0E07;   // y == 0
+static const unsigned int CUBE_Y2 = 0x70381C0;   // y == 2
+static const unsigned int CUBE_Z0 = 0x00001FF;   // z == 0
+static const unsigned int CUBE_Z2 = 0x7FC0000;   // z == 2
+static const unsigned int CUBE_N6 = 0x0415410;   // the 6-adjacent neighbours
+static const unsigned int CUBE_N18 = 0x2EBDEBA;  // the 18-adjacent neighbours, 6-adjacent included
+
+/* Masks of the neighbours found in each z-layer (9 bits) of a cube, built at start-up */
+unsigned int LAYER_MASKS[3][512];
+
+static struct Layer_masks_initializer
+{
+    Layer_masks_initializer()
+    {
+        for (int layer = 0; layer < 3; ++layer)
+        {
+            for (unsigned int bits = 0; bits < 512; ++bits)
+            {
+                LAYER_MASKS[layer][bits] = 0;
+                for (int i = 0; i < 26; ++i)
+                {
+                    if (CUBE_BITS[i] / 9 == layer && (bits >> (CUBE_BITS[i] % 9)) & 1)
+                    {
+                        LAYER_MASKS[layer][bits] |= 1u << i;
+                    }
+                }
+            }
+        }
+    }
+} layer_masks_initializer;
+
+static int connected26(const int np[26], int i, bool *visited);
+static void connected6_18(const int np[26], int i, bool *visited, std::bitset<6>& adjacent);
+static inline void sum_rows(const unsigned char* a, const unsigned char* b, const unsigned char* c,
+                            const unsigned char* minus, unsigned char* sum, int n);
+
+// functions working on the 27 bits of a 3x3x3 cube, to build the simple point table.
+static unsigned int cube_from_mask(unsigned int mask);
+static unsigned int dilate6(unsigned int cube);
+static unsigned int dilate26(unsigned int cube);
+static bool is_cube_26_connected(unsigned int cube);
+static bool is_cube_6_18_connected(unsigned int cube);
+
+/***********************************************  Reference simple point test  definition  **********************************/
+/*******************************************************************************
+*   is_simple : return true if the point is simple, i.e does not alter the
+*               topology of the picture :
+*   1. the set N26(p)∩(B\{p}) is not empty (i.e., p is not an isolated point);
+*   2. the set N26(p)∩(B\{p}) is 26–connected (in itself );
+*   3. the set (ZZ^3\B)∩ N6(p) is not empty (i.e., p is a border point); and
+*   4. the set (ZZ^3\B)∩ N6(p) is 6–connected in the set (ZZ^3\B)∩ N18(p)
+*   @params : 26 neighbour values of p
+*******************************************************************************/
+bool is_simple(const int np[26])
+{
+    if( is_cond_2_satisfied(np) )
+    {
+        if( is_cond_4_satisfied(np ) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/********************************************************************************
+* This condition check if the black points in the neighbourhood
+* of point p are 26-adjacent, to prevent from deleting p which would
+* change topology of B set. (the key of the erosion thinning process).
+* p must be a non end-point to enter this function
+*********************************************************************************/
+bool is_cond_2_satisfied(const int np[26])
+{
+    bool visited[26] = {false};
+    int i = 0;
+    while(!np[i])
+    {
+        visited[i] = true;
+        ++i;
+    }
+
+    int res = connected26(np, i, visited);
+
+    int nb = 0;
+    for(int i = 0; i < 26; ++i)
+    {
+        if(np[i] != 0)
+        {
+            ++nb;
+        }
+    }
+
+    if(res != nb)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/********************************************************************************
+* This is a recursive fonction adding neighbors 26-adjacent in itself
+*********************************************************************************/
+static int connected26(const int np[26], int i, bool *visited)
+{
+    unsigned short nb = 1;
+    visited[i] = true;
+    unsigned short ind;
+    for(int j = INDICESS26[i]; j < INDICESS26[i+1]; ++j)
+    {
+        ind = S26[j];
+        if(!visited[ind] && np[ind])
+        {
+            nb += connected26(np, ind, visited);
+        }
+    }
+
+    return nb;
+}
+
+/********************************************************************************
+* This condition check if the white points in the 6 neighbourhood
+* of point p are 6-adjacent in 18-adjacency to keep the topology
+* of B set. (the key of the erosion thinning process)
+*********************************************************************************/
+bool is_cond_4_satisfied(const int np[26])
+{
+    bool visited[18] = {false};
+    std::bitset<6> adjacent(0b000000);
+    int i = 0;
+    while(np[i])
+    {
+        visited[i] = true;
+        ++i;
+    }
+
+    adjacent[i] = 1;
+    connected6_18(np, i, visited, adjacent);
+
+    if(adjacent.count() != 6 - (np[0] + np[1] + np[2] + np[3] + np[4] + np[5]))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/********************************************************************************
+* This is a recursive fonction adding 6-adjacent neighbors 6-adjacent in 18 set
+********************************************************************************/
+static void connected6_18(const int np[26], int i, bool *visited, std::bitset<6>& adjacent)
+{
+    visited[i] = true;
+    unsigned short ind;
+    for(int j = INDICESS6_18[i]; j < INDICESS6_18[i+1]; ++j)
+    {
+        ind = S6_18[j];
+        if(!visited[ind] && !np[ind])
+        {
+            if(ind >= 0 && ind < 6)
+            {
+                adjacent[ind] = 1;
+            }
+            connected6_18(np, ind, visited, adjacent);
+        }
+    }
+}
+
+/***********************************************  Simple_point_table  definition  *******************************************/
+
+/* Constructors/Destructors */
+Simple_point_table::Simple_point_table()
+{
+    mBits = new unsigned long long[NEIGHBOURHOOD_SIZE / 64];
+
+    /* the background condition only depends on the 18 first neighbours */
+    static const unsigned int N18_SIZE = 1u << 18;
+    std::vector<char> cond_4(N18_SIZE);
+    for (unsigned int mask = 0; mask < N18_SIZE; ++mask)
+    {
+        cond_4[mask] = is_cube_6_18_connected(cube_from_mask(mask));
+    }
+
+    /* the 64 configurations of a word only differ by their 6-adjacent neighbours */
+    unsigned int cube_6[64];
+    for (unsigned int i = 0; i < 64; ++i)
+    {
+        cube_6[i] = cube_from_mask(i);
+    }
+
+    unsigned int mask, cube;
+    for (unsigned int word = 0; word < NEIGHBOURHOOD_SIZE / 64; ++word)
+    {
+        unsigned long long bits = 0;
+        mask = word << 6;
+        cube = cube_from_mask(mask);
+        for (unsigned int i = 0; i < 64; ++i)
+        {
+            if (cond_4[(mask | i) & (N18_SIZE - 1)] && is_cube_26_connected(cube | cube_6[i]))
+            {
+                bits |= 1ull << i;
+            }
+        }
+        mBits[word] = bits;
+    }
+}
+
+Simple_point_table::~Simple_point_table()
+{
+    delete [] mBits;
+}
+
+/* Getters */
+const Simple_point_table& Simple_point_table::instance()
+{
+    static const Simple_point_table table;
+    return table;
+}
+
+/***********************************************  UTILITIES  definition  ****************************************************/
+/*******************************************************************************
+*   neighbour_counts : separable box sum, a layer at a time. Each layer is
+*                      summed along x then y, into the 3x3 sums of a ring of
+*                      3 layers, and the counts of a layer are the sum of the
+*                      3x3 sums of its own and its 2 neighbour layers, minus
+*                      the point. The sums are computed on whole layers, so
+*                      those of the x borders mix up rows, and are reset.
+*                      The largest sum is 27, every sum fits a byte.
+*******************************************************************************/
+void neighbour_counts(const unsigned char* data, const Sizes& sizes, unsigned char* counts)
+{
+    const int row = sizes.size_x_enlarged;
+    const int layer = sizes.xOy_enlarged_size;
+    const int layers = sizes.size_z_enlarged;
+
+    std::vector<unsigned char> rows(layer, 0);
+    std::vector<unsigned char> squares(3 * layer, 0);
+
+    memset(counts, 0, layer);
+    memset(counts + (std::size_t)(layers - 1) * layer, 0, layer);
+
+    for (int z = 0; z < layers; ++z)
+    {
+        const unsigned char* d = data + (std::size_t)z * layer;
+        unsigned char* square = &squares[(z % 3) * layer];
+
+        sum_rows(d, d + 1, d + 2, 0, &rows[1], layer - 2);
+        sum_rows(&rows[0], &rows[row], &rows[2 * row], 0, square + row, layer - 2 * row);
+
+        if (z >= 2)
+        {
+            const std::size_t p = (std::size_t)(z - 1) * layer;
+            sum_rows(&squares[((z - 2) % 3) * layer], &squares[((z - 1) % 3) * layer], square, data + p,
+                     counts + p, layer);
+
+            for (int y = 0; y < (int)sizes.size_y_enlarged; ++y)
+            {
+                counts[p + y * row] = counts[p + y * row + row - 1] = 0;
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+*   sum_rows : sum[i] = a[i] + b[i] + c[i] (- minus[i]) for i in [0, n).
+*******************************************************************************/
+static inline void sum_rows(const unsigned char* a, const unsigned char* b, const unsigned char* c,
+                            const unsigned char* minus, unsigned char* sum, int n)
+{
+    int i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i s = _mm256_add_epi8(_mm256_loadu_si256((const __m256i*)(a + i)), _mm256_loadu_si256((const __m256i*)(b + i)));
+        s = _mm256_add_epi8(s, _mm256_loadu_si256((const __m256i*)(c + i)));
+        if (minus)
+        {
+            s = _mm256_sub_epi8(s, _mm256_loadu_si256((const __m256i*)(minus + i)));
+        }
+        _mm256_storeu_si256((__m256i*)(sum + i), s);
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i s = _mm_add_epi8(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+        s = _mm_add_epi8(s, _mm_loadu_si128((const __m128i*)(c + i)));
+        if (minus)
+        {
+            s = _mm_sub_epi8(s, _mm_loadu_si128((const __m128i*)(minus + i)));
+        }
+        _mm_storeu_si128((__m128i*)(sum + i), s);
+    }
+#endif
+
+    for (; i < n; ++i)
+    {
+        sum[i] = a[i] + b[i] + c[i] - (minus ? minus[i] : 0);
+    }
+}
+
+/*******************************************************************************
+*   neighbour_delta : save the x, y, z offsets of the neighbour n in delta.
+*******************************************************************************/
+void neighbour_delta(int n, int delta[3])
+{
+    delta[0] = CUBE_BITS[n] % 3 - 1;
+    delta[1] = CUBE_BITS[n] / 3 % 3 - 1;
+    delta[2] = CUBE_BITS[n] / 9 - 1;
+}
+
+/*******************************************************************************
+*   neighbourhood_mask : pack 26 binary neighbour values into a mask.
+*******************************************************************************/
+unsigned int neighbourhood_mask(const int np[26])
+{
+    unsigned int mask = 0;
+    for (int i = 0; i < 26; ++i)
+    {
+        if (np[i])
+        {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+/*******************************************************************************
+*   neighbourhood_values : unpack a mask into 26 binary neighbour values.
+*******************************************************************************/
+void neighbourhood_values(unsigned int mask, int np[26])
+{
+    for (int i = 0; i < 26; ++i)
+    {
+        np[i] = (mask >> i) & 1;
+    }
+}
+
+/*******************************************************************************
+*   is_simple_mask : same test as is_simple, using bitwise flood fills on
+*                    the 3x3x3 cube instead of the recursive ones.
+*******************************************************************************/
+bool is_simple_mask(unsigned int mask)
+{
+    unsigned int cube = cube_from_mask(mask);
+    return is_cube_6_18_connected(cube) && is_cube_26_connected(cube);
+}
+
+/*******************************************************************************
+*   check_simple_point_table : compare the table with the recursive
+*   reference test, on the whole 18-neighbourhood and on random
+*   configurations. Return false at the first mismatch.
+*******************************************************************************/
+bool check_simple_point_table(unsigned int samples)
+{
+    const Simple_point_table& table = Simple_point_table::instance();
+    int np[26];
+    unsigned int mask;
+    bool reference;
+
+    for (unsigned int i = 0; i < samples; ++i)
+    {
+        mask = ((unsigned int)rand() << 13 ^ (unsigned int)rand()) & (NEIGHBOURHOOD_SIZE - 1);
+        neighbourhood_values(mask, np);
+
+        // the reference test requires a border and non isolated point.
+        reference = (mask & N6_MASK) != N6_MASK && mask != 0 && is_simple(np);
+        if (reference != table.is_simple(mask))
+        {
+            std::cerr << "simple point table mismatch for configuration " << mask << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/********************************************************************************
+* is_26_connected : condition 2 of is_simple on a neighbourhood mask
+*********************************************************************************/
+bool is_26_connected(unsigned int mask)
+{
+    return is_cube_26_connected(cube_from_mask(mask));
+}
+
+/********************************************************************************
+* This function converts a neighbourhood mask into the bits of a 3x3x3 cube
+* (mask_from_cube does the reverse, and drops the central point).
+*********************************************************************************/
+static unsigned int cube_from_mask(unsigned int mask)
+{
+    unsigned int cube = 0;
+    for (int i = 0; i < 26; ++i)
+    {
+        cube |= ((mask >> i) & 1) << CUBE_BITS[i];
+    }
+    return cube;
+}
+
+/********************************************************************************
+* These functions add to a set of the cube its 6 (resp. 26) adjacent points
+*********************************************************************************/
+static unsigned int dilate6(unsigned int cube)
+{
+    return (cube
+         | ((cube << 1) & ~CUBE_X0) | ((cube >> 1) & ~CUBE_X2)
+         | ((cube << 3) & ~CUBE_Y0) | ((cube >> 3) & ~CUBE_Y2)
+         | (cube << 9) | (cube >> 9)) & CUBE_FULL;
+}
+
+static unsigned int dilate26(unsigned int cube)
+{
+    cube |= (((cube << 1) & ~CUBE_X0) | ((cube >> 1) & ~CUBE_X2)) & CUBE_FULL;
+    cube |= (((cube << 3) & ~CUBE_Y0) | ((cube >> 3) & ~CUBE_Y2)) & CUBE_FULL;
+    cube |= (cube << 9) | (cube >> 9);
+    return cube & CUBE_FULL;
+}
+
+/********************************************************************************
+* Condition 2 on the cube : the black points of N26(p)\{p} are 26-connected
+*********************************************************************************/
+static bool is_cube_26_connected(unsigned int cube)
+{
+    unsigned int black = cube & ~CUBE_CENTER;
+    if (!black)
+    {
+        return false;
+    }
+
+    unsigned int component = black & (~black + 1);
+    unsigned int previous;
+    do
+    {
+        previous = component;
+        component = dilate26(component) & black;
+    } while (component != previous);
+
+    return component == black;
+}
+
+/********************************************************************************
+* Condition 3 and 4 on the cube : the white 6-neighbours exist and are
+* 6-connected in the white points of N18(p)
+*********************************************************************************/
+static bool is_cube_6_18_connected(unsigned int cube)
+{
+    unsigned int white = ~cube & CUBE_N18;
+    unsigned int white_6 = white & CUBE_N6;
+    if (!white_6)
+    {
+        return false;
+    }
+
+    unsigned int component = white_6 & (~white_6 + 1);
+    unsigned int previous;
+    do
+    {
+        previous = component;
+        component = dilate6(component) & white;
+    } while (component != previous);
+
+    return (component & CUBE_N6) == white_6;
+}
+
+} // end of namespace Trabecula
@@ -17,6 +17,10 @@
 
 #include "trabecula/analyze_loader.hpp"
 #include "trabecula/tubular_object.hpp"
+#include "trabecula/topology.hpp"
+#include "trabecula/thinning.hpp"
+#include "trabecula/occupancy.hpp"
+#include "trabecula/graph_labels.hpp"
 
 #include <iostream>
 #include <cstring>
@@ -24,110 +28,33 @@
 #include <cmath>
 #include <limits>
 
-#include <bitset>
-
 namespace Trabecula
 {
 
 /***********************************************  UTILITIES  declaration  ***************************************************/
 
-/* This constant provides all the 26-adjacent neighbours of each of the 26 neighbours of a point */
-static const unsigned short S26[171] = {
-    1, 2, 3, 4, 6, 7, 8, 9, 10, 11, 12, 13, 18, 19, 20, 21    //    U
-  , 2, 3, 5, 6, 7, 8, 10, 11, 14, 15, 16, 18, 19, 22, 23      //     N
-  , 4, 5, 6, 7, 9, 10, 12, 14, 15, 17, 18, 20, 22, 24         // W
-  , 4, 5, 6, 8, 9, 11, 13, 14, 16, 17, 19, 21, 23, 25         // E
-  , 3, 5, 7, 8, 9, 12, 13, 15, 16, 17, 20, 21, 24, 25         //     S
-  , 3, 4, 10, 11, 12, 13, 14, 15, 16, 17, 22, 23, 24, 25      //   D
-
-  , 3, 7, 8, 10, 11, 18, 19                                   //   U N
-  , 4, 6, 9, 10, 12, 18, 20                                   // W U
-  , 4, 6, 9, 11, 13, 19, 21                                   // E U
-  , 3, 7, 8, 12, 13, 20, 21                                   //   U S
-  , 5, 6, 7, 14, 15, 18, 22                                   // W   N
-  , 5, 6, 8, 14, 16, 19, 23                                   // E   N
-  , 5, 7, 9, 15, 17, 20, 24                                   // W   S
-  , 5, 8, 9, 16, 17, 21, 25                                   // E   S
-  , 3, 10, 11, 15, 16, 22, 23                                 //   D N
-  , 4, 10, 12, 14, 17, 22, 24                                 // W D
-  , 4, 11, 13, 14, 17, 23, 25                                 // E D
-  , 3, 12, 13, 15, 16, 24, 25                                 //   D S
-
-                                                              // W U N
-                                                              // E U N
-                                                              // W U S
-                                                              // E U S
-                                                              // W D N
-                                                              // E D N
-                                                              // W D S
-                                                              // E D S
-                                        };
-
-/* This constant provides the 6-adjacent neighbours of the 18 neighbours of a point */
-static const unsigned short S6_18[48] = {
-   6, 7, 8, 9        //    U
- , 6, 10, 11, 14     //     N
- , 7, 10, 12, 15     // W
- , 8, 11, 13, 16     // E
- , 9, 12, 13, 17     //     S
- , 14, 15, 16, 17    //   D
- , 1, 0              //   U N
- , 2, 0              // W U
- , 3, 0              // E U
- , 4, 0              //   U S
- , 2, 1              // W   N
- , 3, 1              // E   N
- , 4, 2              // W   S
- , 3, 4              // E   S
- , 1, 5              //   D N
- , 2, 5              // W D
- , 3, 5              // E D
- , 4, 5              //   D S
-
-                    // W U N
-                    // E U N
-                    // W U S
-                    // E U S
-                    // W D N
-                    // E D N
-                    // W D S
-                    // E D S
-                                        };
-
-
-static const unsigned short INDICESS26[27] = {0, 16, 31, 45, 59, 73, 87, 94, 101, 108, 115, 122, 129, 136, 143, 150, 157, 164, 171, 171, 171, 171, 171, 171, 171, 171, 171};
-static const unsigned short INDICESS6_18[19] = {0, 4, 8, 12, 16, 20, 24, 26, 28, 30, 32, 34, 36, 38, 40, 42, 44, 46, 48};
 static const float BRANCH_THRESHOLD = 5.0;
 static const float EDGE_THRESHOLD = 2.1;
 
 // functions mostly related to the skeletonization process, but not only.
-static int skeletonize_data(const unsigned char* data, unsigned char* skeleton, const Sizes& sizes);
-static int subiter(unsigned char* data, std::list<int>& black_points_set, int direction, const Sizes& sizes);
-static bool is_border_point(const unsigned char* data, int direction, int p);
-static void collect_26_neighbours( int p, const Sizes& sizes, int np[26] );
-static bool is_simple( const int np[26]);
-static int connected26(const int np[26], int i, bool *visited);
-static bool is_cond_2_satisfied(const int np[26]);
-static void connected6_18(const int np[26], int i, bool *visited, std::bitset<6>& adjacent);
-static bool is_cond_4_satisfied(const int np[26]);
 
 //functions to border data with zeroes, and get the indice from the original.
-static void bordering(const unsigned char* from, unsigned char* with_borders, const Sizes& sizes);
+static void bordering(const unsigned char* from, Bit_volume& with_borders, const Sizes& sizes);
 static int untransformed(int indice, const Sizes& sizes);
 
 //functions to build the graph.
-static int find_edge(const unsigned char *thinned, const Sizes& sizes, int np[26]);
-static void identify_voxels(int ind, const unsigned char *data, const Sizes& sizes, std::pair<Node*, Edge*>* voxel_ids);
-static void remove_small_branches(const Sizes& sizes, std::pair<Node*, Edge*>* voxel_ids);
-static void refine_nodes(const Sizes& sizes, std::pair<Node*, Edge*>* voxel_ids);
-static bool is_node_refinable(int ind, const Edge* edge, const Sizes& sizes, std::pair<Node*, Edge*>*voxel_ids);
-static bool is_branch(const Edge* edge, Node*& node_back, Node*& node_front, const Sizes& sizes, const std::pair<Node*, Edge*>* voxel_ids);
-static void fusion_nodes(const Sizes& sizes, std::pair<Node*, Edge*>* voxel_ids);
+static int find_edge(const unsigned char *thinned, const unsigned char *counts, const Sizes& sizes, const Occupancy& occupancy);
+static void identify_voxels(int ind, const unsigned char *data, const unsigned char *counts, const Sizes& sizes, Graph_labels& labels);
+static void remove_small_branches(const Sizes& sizes, Graph_labels& labels, const Occupancy& occupancy);
+static void refine_nodes(const Sizes& sizes, Graph_labels& labels, const Occupancy& occupancy);
+static bool is_node_refinable(int ind, int edge, const Sizes& sizes, const Graph_labels& labels);
+static bool is_branch(const Edge* edge, int& node_back, int& node_front, const Sizes& sizes, const Graph_labels& labels);
+static void fusion_nodes(const Sizes& sizes, Graph_labels& labels, const Occupancy& occupancy);
 
 /***********************************************  TubularObject  definition  ************************************************/
 
 /* Constructors/Destructors */
-Tubular_object::Tubular_object(): mData(0), mSkeleton(0), mDsr(0)
+Tubular_object::Tubular_object(): mDsr(0), mLayout(FLAT_LAYOUT)
 {
 
 }
@@ -135,18 +62,6 @@ Tubular_object::Tubular_object(): mData(0), mSkeleton(0), mDsr(0)
 Tubular_object::~Tubular_object()
 {
     delete mDsr;
-    delete [] mData;
-    delete [] mSkeleton;
-
-    for (std::list<Edge*>::const_iterator it = mEdges.begin(); it != mEdges.end(); ++it)
-    {
-        delete *it;
-    }
-
-    for (std::list<Node*>::const_iterator it = mNodes.begin(); it != mNodes.end(); ++it)
-    {
-        delete *it;
-    }
 }
 
 /* Setters */
@@ -154,24 +69,19 @@ Tubular_object::~Tubular_object()
 
 
 /* Getters */
-const unsigned char* Tubular_object::data() const
+const Bit_volume& Tubular_object::data() const
 {
     return mData;
 }
 
-const unsigned char* Tubular_object::skeleton_data() const
+const Bit_volume& Tubular_object::skeleton_data() const
 {
     return mSkeleton;
 }
 
-const std::list<Node*>& Tubular_object::nodes() const
-{
-    return mNodes;
-}
-
-const std::list<Edge*>& Tubular_object::edges() const
+const Graph& Tubular_object::graph() const
 {
-    return mEdges;
+    return mGraph;
 }
 
 const ANALYZE_DSR* Tubular_object::dsr() const
@@ -184,6 +94,16 @@ const Sizes& Tubular_object::sizes() const
     return mSizes;
 }
 
+const std::vector<unsigned int>& Tubular_object::labels() const
+{
+    return mLabels;
+}
+
+const std::vector<Component_stats>& Tubular_object::components() const
+{
+    return mComponents;
+}
+
  /* Member Functions */
 int Tubular_object::load_from_file(const std::string& filename)
 {
@@ -215,10 +135,9 @@ int Tubular_object::load_from_file(const std::string& filename)
     mSizes.xOy_size = mSizes.size_x * mSizes.size_y;
     mSizes.xOy_enlarged_size = mSizes.size_x_enlarged * mSizes.size_y_enlarged;
 
-    mSkeleton = new unsigned char[ mSizes.size_enlarged ];
-    memset(mSkeleton, 0, mSizes.size_enlarged * sizeof(unsigned char));
+    mSkeleton.resize(mSizes.size_enlarged);
+    mData.resize(mSizes.size_enlarged);
 
-    mData = new unsigned char[ mSizes.size_enlarged ];
     unsigned char* data_tmp = new unsigned char[mSizes.size];
 
     if(anaReadImagedata(imageFilename.c_str(), mDsr, 1, (char*)data_tmp))
@@ -228,6 +147,8 @@ int Tubular_object::load_from_file(const std::string& filename)
     }
     bordering(data_tmp, mData, mSizes);
     delete [] data_tmp;
+
+    return 0;
 }
 
 /********************************************************************
@@ -239,16 +160,111 @@ float Tubular_object::bv_tv() const
 {
     static const float pi = 3.14159265;
     float total = 1.0/6.0 * pi * mSizes.size; // 4/3 * Pi * R^3
-    float nb_object_voxels = 0.0;
+    float nb_object_voxels = mData.count();
+
+    return nb_object_voxels/total * 100.0;
+}
+
+/******************************************************************************************
+* Label Components : this function labels the 26-connected components of the image on
+* 'threads' threads (0 for all the hardware threads), and returns their number. The labels
+* and the stats of the components are kept for the other measures.
+******************************************************************************************/
+int Tubular_object::label_components(unsigned int threads)
+{
+    unsigned char *data_tmp = new unsigned char[mSizes.size_enlarged];
+    mData.unpack(data_tmp);
+
+    Thread_pool pool(threads);
+    mLabels.resize(mSizes.size_enlarged);
+    const int components = Trabecula::label_components(data_tmp, mSizes, &mLabels[0], mComponents, pool);
+
+    delete [] data_tmp;
+
+    return components;
+}
+
+/******************************************************************************************
+* Remove Small Components : this function deletes from the image the components of less
+* than min_voxels voxels, the specks left by the segmentation noise, so that they do not
+* give fragments of skeleton and graph. To be called before skeletonize(). The stats of
+* the components are kept, until fill_cavities fills a cavity, but their labels, 4 bytes
+* per voxel, are freed unless keep_labels is set: then only the labels of the deleted
+* voxels are cleared, until fill_cavities frees them. Call label_components() again after
+* the clean-up passes to reuse them. It returns the number of deleted components.
+******************************************************************************************/
+int Tubular_object::remove_small_components(int min_voxels, unsigned int threads, bool keep_labels)
+{
+    label_components(threads);
+
+    int removed = 0;
+    for (std::size_t l = 0; l < mComponents.size(); ++l)
+    {
+        removed += mComponents[l].voxels < min_voxels;
+    }
 
-    for (int i = 0; i < mSizes.size_enlarged; ++i)
+    if (removed)
     {
-        if(mData[i])
+        for (unsigned int i = mData.next(0); i < mData.size(); i = mData.next(i + 1))
         {
-            nb_object_voxels += 1.0;
+            if (mComponents[mLabels[i] - 1].voxels < min_voxels)
+            {
+                mData.reset(i);
+                mLabels[i] = 0;
+            }
         }
     }
-    return nb_object_voxels/total * 100.0;
+
+    if (!keep_labels)
+    {
+        std::vector<unsigned int>().swap(mLabels);
+    }
+
+    return removed;
+}
+
+/******************************************************************************************
+* Fill Cavities : this function fills the cavities of the image (background components
+* enclosed by the object) of at most max_voxels voxels, which the thinning would keep
+* as loops of the skeleton, and so as cycles of the graph. To be called before
+* skeletonize(). The labels of the components are freed first, so that the two label
+* volumes are never held together; their stats are kept, unless a cavity is filled,
+* which changes the components. It returns the number of filled cavities.
+******************************************************************************************/
+int Tubular_object::fill_cavities(int max_voxels, unsigned int threads)
+{
+    std::vector<unsigned int>().swap(mLabels);
+
+    unsigned char *data_tmp = new unsigned char[mSizes.size_enlarged];
+    mData.unpack(data_tmp);
+
+    Thread_pool pool(threads);
+    std::vector<unsigned int> labels(mSizes.size_enlarged);
+    std::vector<Component_stats> cavities;
+    label_background_components(data_tmp, mSizes, &labels[0], cavities, pool);
+    delete [] data_tmp;
+
+    /* the first background component is the outside */
+    int filled = 0;
+    for (std::size_t l = 1; l < cavities.size(); ++l)
+    {
+        filled += cavities[l].voxels <= max_voxels;
+    }
+
+    if (filled)
+    {
+        for (int i = 0; i < (int)mSizes.size_enlarged; ++i)
+        {
+            if (labels[i] > 1 && cavities[labels[i] - 1].voxels <= max_voxels)
+            {
+                mData.set(i);
+            }
+        }
+
+        std::vector<Component_stats>().swap(mComponents);
+    }
+
+    return filled;
 }
 
 /*******************************************************************************
@@ -260,22 +276,23 @@ void Tubular_object::average_trabecular_length(float values[4])
     values[0] = 0.0;
     float min = (float) std::numeric_limits<int>::max();
     float max = 0.0;
-    float variance;
+    float variance = 0.0;
     float tmp;
 
-    for (std::list<Edge*>::const_iterator it = mEdges.begin(); it != mEdges.end(); ++it)
+    const std::vector<float>& lengths = mGraph.lengths();
+    for (std::size_t e = 0; e < lengths.size(); ++e)
     {
-       values[0] += (*it)->length();
-       if((*it)->length() > max)
+       values[0] += lengths[e];
+       if(lengths[e] > max)
        {
             // max
-            max = (*it)->length();
+            max = lengths[e];
        }
 
-       if((*it)->length() < min && (*it)->length() > 2.0)
+       if(lengths[e] < min && lengths[e] > 2.0)
        {
             // min
-            min = (*it)->length();
+            min = lengths[e];
        }
     }
 
@@ -283,17 +300,17 @@ void Tubular_object::average_trabecular_length(float values[4])
     values[2] = max * mDsr->dime.pixdim[1];
 
     // standard Mean
-    values[0] = values[0]/mEdges.size() * mDsr->dime.pixdim[1];
+    values[0] = values[0]/lengths.size() * mDsr->dime.pixdim[1];
 
-    for (std::list<Edge*>::const_iterator it = mEdges.begin(); it != mEdges.end(); ++it)
+    for (std::size_t e = 0; e < lengths.size(); ++e)
     {
-        tmp = std::abs(values[0] - (*it)->length());
+        tmp = std::abs(values[0] - lengths[e]);
         tmp = tmp * tmp;
         variance += tmp;
     }
 
     // standard Deviation
-    values[3] = std::sqrt(variance/mEdges.size()) * mDsr->dime.pixdim[1];
+    values[3] = std::sqrt(variance/lengths.size()) * mDsr->dime.pixdim[1];
 }
 
 /*******************************************************************************
@@ -301,7 +318,7 @@ void Tubular_object::average_trabecular_length(float values[4])
 ********************************************************************************/
 int Tubular_object::number_of_trabeculae()
 {
-    return mEdges.size();
+    return mGraph.edge_count();
 }
 
 /*******************************************************************************
@@ -311,9 +328,10 @@ void Tubular_object::nodes_connectivity(std::vector<int>& con)
 {
     int connectivity[26] = {};
 
-    for (std::list<Node*>::const_iterator it = mNodes.begin(); it != mNodes.end(); ++it)
+    const std::vector<int>& connectivities = mGraph.connectivities();
+    for (std::size_t n = 0; n < connectivities.size(); ++n)
     {
-        ++connectivity[(*it)->connectivity()];
+        ++connectivity[connectivities[n]];
     }
 
     for (int i = 0; i < 26; ++i)
@@ -345,11 +363,14 @@ void Tubular_object::tb_shape()
 
 /******************************************************************************************
 * Skeletonize : this function compute a skeleton of tubular object and store
-* its result in the skeleton data structure.
+* its result in the skeleton data structure. The subfield mode runs on 'threads' threads
+* (0 for all the hardware threads). The image is thinned in the given layout, which is
+* kept for the thinning of build_graph.
 ******************************************************************************************/
-int Tubular_object::skeletonize()
+int Tubular_object::skeletonize(Thinning_mode mode, unsigned int threads, Volume_layout layout)
 {
-    return skeletonize_data(mData, mSkeleton, mSizes);
+    mLayout = layout;
+    return skeletonize_data(mData, mSkeleton, mSizes, mode, threads, layout);
 }
 
 /******************************************************************************************
@@ -358,7 +379,7 @@ int Tubular_object::skeletonize()
 ******************************************************************************************/
 int Tubular_object::build_graph()
 {
-    if(!mSkeleton)
+    if(mSkeleton.empty())
     {
         std::cerr << "error, no skeleton!" << std::endl;
         return 1;
@@ -366,122 +387,121 @@ int Tubular_object::build_graph()
 
     /*  Create a copy of data with binary values and zero borders */
     unsigned char *data_tmp = new unsigned char[mSizes.size_enlarged];
-    for (int i = 0; i < mSizes.size_enlarged; ++i)
-    {
-        data_tmp[i] = mSkeleton[i];
-    }
+    mSkeleton.unpack(data_tmp);
+
+    /*  The voxels of the skeleton, and so of its nodes and edges, lie in the occupied blocks */
+    Occupancy occupancy(mSizes);
+    occupancy.build(mSkeleton);
+
+    /*  Create a label array to mark every voxel with edge or node status */
+    Graph_labels labels(mSizes);
 
-    /*  Create a marker pair array to mark every voxel with edge or node status */
-    std::pair<Node*, Edge*>* voxel_ids = new std::pair<Node*, Edge*>[mSizes.size_enlarged];
-    memset(voxel_ids, 0, mSizes.size_enlarged * sizeof(std::pair<Node*, Edge*>));
+    /*  Count the neighbours of every voxel once: 1 on an end, 2 on an edge, more on a node */
+    unsigned char *counts = new unsigned char[mSizes.size_enlarged];
+    neighbour_counts(data_tmp, mSizes, counts);
 
     /*  Find the indice of a starting edge */
     int np[26];
-    int ind = find_edge(data_tmp, mSizes, np);
+    int ind = find_edge(data_tmp, counts, mSizes, occupancy);
 
     if(ind == mSizes.size_enlarged)
     {
         std::cerr << "couldnt build graph, skeleton is empty or no nodes in it!" << std::endl;
+        delete [] counts;
+        delete [] data_tmp;
         return 2;
     }
 
     /** FIRST PASS: Remove the noisy branches on the skeleton. **/
 
     /* Compute a depth-first search to create the nodes and edges */
-    identify_voxels(ind, data_tmp, mSizes, voxel_ids);
+    identify_voxels(ind, data_tmp, counts, mSizes, labels);
 
     /* Refine the nodes to their minimum of voxels             */
-    refine_nodes(mSizes, voxel_ids);
+    refine_nodes(mSizes, labels, occupancy);
 
     /* Delete any of the branches which are smaller than a threshold
         (noise from skeletonization, or segmentation)                       */
-    remove_small_branches(mSizes, voxel_ids);
+    remove_small_branches(mSizes, labels, occupancy);
 
-    for (int i = 0; i < mSizes.size_enlarged; ++i)
+    /* the skeleton keeps the voxels of the remaining nodes and edges */
+    std::vector<int> removed;
+    for (int i = occupancy.next(0); i < mSizes.size_enlarged; i = occupancy.next(i + 1))
     {
-        if(voxel_ids[i].second || voxel_ids[i].first )
+        if(data_tmp[i] && !labels.label(i))
         {
-            mSkeleton[i] = 1;
-        }
-        else
-        {
-            mSkeleton[i] = 0;
+            data_tmp[i] = 0;
+            occupancy.remove(i);
+            removed.push_back(i);
         }
     }
 int nb = 0;
 
-    // reskeletonize after deleting noisy branches to prepare the second pass.
-    skeletonize_data(mSkeleton, mSkeleton, mSizes);
+    // reskeletonize around the deleted branches to prepare the second pass.
+    rethin_data(data_tmp, mSizes, removed, mLayout);
 
-    // Free the memory allocated by nodes and edges before Second pass
-    Node* node_tmp;
-    Edge* edge_tmp;
-    for (int i = 0; i < mSizes.size_enlarged; ++i)
+    // the thinning only deletes voxels: update the counts around the ones deleted since the first pass.
+    for (unsigned int i = mSkeleton.next(0); i < mSkeleton.size(); i = mSkeleton.next(i + 1))
     {
-        if(voxel_ids[i].first)
+        if(!data_tmp[i])
         {
-            node_tmp = voxel_ids[i].first;
-            for (std::list<int>::const_iterator it = node_tmp->positions().begin(); it != node_tmp->positions().end(); ++it)
-            {
-
-                voxel_ids[*it].first = 0;
-            }
-            delete node_tmp;
-        }
-        else if(voxel_ids[i].second)
-        {
-            edge_tmp = voxel_ids[i].second;
-            for (std::deque<int>::const_iterator it = edge_tmp->data().begin(); it != edge_tmp->data().end(); ++it)
+            collect_26_neighbours(i, mSizes, np);
+            for (int j = 0; j < 26; ++j)
             {
-                voxel_ids[*it].second = 0;
+                --counts[np[j]];
             }
-            delete edge_tmp;
         }
-
-        data_tmp[i] = mSkeleton[i];
     }
+    mSkeleton.pack(data_tmp);
+
+    // Free the memory allocated by nodes and edges before Second pass, at once
+    labels.clear();
 
     /** SECOND PASS: Fusion the nodes that are connected each other by a too small edge **/
-    ind = find_edge(data_tmp, mSizes, np);
+    ind = find_edge(data_tmp, counts, mSizes, occupancy);
 
     /* Compute a depth-first search to create the nodes and edges */
-    identify_voxels(ind, data_tmp, mSizes, voxel_ids);
+    identify_voxels(ind, data_tmp, counts, mSizes, labels);
 
     /* Refine the nodes to their minimum of voxels             */
-    refine_nodes(mSizes, voxel_ids);
+    refine_nodes(mSizes, labels, occupancy);
 
     /* fusion the nodes that are too close (separated by an edge smaller than EDGE_THRESHOLD) */
-    fusion_nodes(mSizes, voxel_ids);
+    fusion_nodes(mSizes, labels, occupancy);
 
-    /** FINAL PASS, list of Edges and Nodes and their adjacencies. **/
-    bool* visited_tmp = new bool[mSizes.size_enlarged];
-    memset(visited_tmp, 0, mSizes.size_enlarged * sizeof(bool));
+    /** FINAL PASS, flat graph of the Edges and Nodes and their adjacencies. **/
+    Bit_volume visited_tmp(mSizes.size_enlarged);
+    mGraph.clear();
 
     // for each edges, stores the connected nodes, stores the edge to the connected nodes
-    // and fill the list of edges and nodes not yet visited to the tubular object.
-    for (int i = 0; i < mSizes.size_enlarged; ++i)
+    // and copy the edges and nodes not yet visited to the graph, numbered in visit order.
+    std::vector<int> node_ids(labels.node_count(), -1);
+    Edge* edge_tmp;
+    int node_tmp = 0;
+    int edge_id;
+    for (int i = occupancy.next(0); i < mSizes.size_enlarged; i = occupancy.next(i + 1))
     {
-        if(voxel_ids[i].second)
+        if(labels.label(i) > 0)
         {
-            edge_tmp = voxel_ids[i].second;
-            if(!visited_tmp[edge_tmp->data().back()])
+            edge_tmp = labels.edge_at(i);
+            if(!visited_tmp.test(edge_tmp->data().back()))
             {
-                visited_tmp[edge_tmp->data().back()] = true;
-                mEdges.push_back(edge_tmp);
+                visited_tmp.set(edge_tmp->data().back());
+                edge_id = mGraph.add_edge(edge_tmp->data().begin(), edge_tmp->data().end(), edge_tmp->length());
 
                 collect_26_neighbours(edge_tmp->data().front(), mSizes, np);
                 for (int j = 0; j < 26; ++j)
                 {
-                    if (voxel_ids[np[j]].first)
+                    if (labels.label(np[j]) < 0)
                     {
-                        node_tmp = voxel_ids[np[j]].first;
-                        node_tmp->add_edge(edge_tmp);
-
-                        if (!visited_tmp[*(node_tmp->positions().begin())])
+                        node_tmp = labels.label(np[j]);
+                        int& node_id = node_ids[-node_tmp - 1];
+                        if (node_id == -1)
                         {
-                            mNodes.push_back(node_tmp);
-                            visited_tmp[*(node_tmp->positions().begin())] = true;
+                            node_id = mGraph.add_node(labels.node(node_tmp)->positions().begin(), labels.node(node_tmp)->positions().end(),
+                                                   labels.node(node_tmp)->connectivity());
                         }
+                        mGraph.connect(node_id, edge_id);
 
                         break;
                     }
@@ -490,16 +510,16 @@ int nb = 0;
                 collect_26_neighbours(edge_tmp->data().back(), mSizes, np);
                 for (int j = 0; j < 26; ++j)
                 {
-                    if (voxel_ids[np[j]].first && node_tmp != voxel_ids[np[j]].first)
+                    if (labels.label(np[j]) < 0 && node_tmp != labels.label(np[j]))
                     {
-                        node_tmp = voxel_ids[np[j]].first;
-                        node_tmp->add_edge(edge_tmp);
-
-                        if (!visited_tmp[*(node_tmp->positions().begin())])
+                        node_tmp = labels.label(np[j]);
+                        int& node_id = node_ids[-node_tmp - 1];
+                        if (node_id == -1)
                         {
-                            mNodes.push_back(node_tmp);
-                            visited_tmp[*(node_tmp->positions().begin())] = true;
+                            node_id = mGraph.add_node(labels.node(node_tmp)->positions().begin(), labels.node(node_tmp)->positions().end(),
+                                                   labels.node(node_tmp)->connectivity());
                         }
+                        mGraph.connect(node_id, edge_id);
 
                         break;
                     }
@@ -507,9 +527,10 @@ int nb = 0;
             }
         }
     }
+    mGraph.build_adjacency();
 
-    delete [] visited_tmp;
-    delete [] voxel_ids;
+    // the nodes and edges are freed with their labels, the graph keeps a copy.
+    delete [] counts;
     delete [] data_tmp;
 
     return 0;
@@ -559,6 +580,8 @@ int Tubular_object::dump_infos()
     //tb_shape();
 
     myfile.close();
+
+    return 0;
 }
 
 /******************************************************************************************
@@ -569,17 +592,14 @@ int Tubular_object::save_skeleton()
     unsigned char* tmp = new unsigned char[ mSizes.size ];
     memset(tmp, 0, mSizes.size * sizeof(unsigned char));
 
-    for (int i = 0; i < mSizes.size_enlarged; ++i)
+    for (unsigned int i = mSkeleton.next(0); i < mSkeleton.size(); i = mSkeleton.next(i + 1))
     {
-        if(mSkeleton[i])
-        {
-            tmp[untransformed(i, mSizes)] = 1;
-        }
+        tmp[untransformed(i, mSizes)] = 1;
     }
 
     std::string filename;
     filename = mFilename + "_skeleton.img";
-    if(anaWriteImagedata(filename.c_str(), mDsr, (char*)mSkeleton))
+    if(anaWriteImagedata(filename.c_str(), mDsr, (char*)tmp))
     {
         return 1;
     }
@@ -591,12 +611,14 @@ int Tubular_object::save_skeleton()
     }
 
     delete [] tmp;
+
+    return 0;
 }
 
 /***********************************************  Node  definition  *********************************************************/
 
 /* Constructors/Destructors */
-Node::Node() : mConnectivity(0)
+Node::Node(Arena& arena) : mPositions(Arena_allocator<int>(arena)), mConnectivity(0)
 {
 }
 
@@ -616,23 +638,12 @@ int Node::connectivity() const
     return mConnectivity;
 }
 
-const std::list<Edge*>& Node::edges() const
-{
-    return mEdges;
-}
-
-const std::list<int>& Node::positions() const
+const Node::Positions& Node::positions() const
 {
     return mPositions;
 }
 
 /* Member Functions */
-void Node::add_edge(Edge* edge)
-{
-    edge->set_nodes(this);
-    mEdges.push_back(edge);
-}
-
 void Node::add_voxel(int indice)
 {
     mPositions.push_back(indice);
@@ -647,7 +658,7 @@ void Node::remove_voxel(int indice)
 
 /* Constructors/Destructors */
 
-Edge::Edge() : mLength(0.0), mFirst(0), mSecond(0)
+Edge::Edge(Arena& arena) : mLength(0.0), mIndices(Arena_allocator<int>(arena))
 {
 }
 
@@ -655,36 +666,13 @@ Edge::~Edge()
 {
 }
 
-/* Setters */
-void Edge::set_nodes(Node* node)
-{
-    if(!mFirst)
-    {
-        mFirst = node;
-    }
-    else
-    {
-        mSecond = node;
-    }
-}
-
 /* Getters */
 float Edge::length() const
 {
     return mLength;
 }
 
-const Node* Edge::first() const
-{
-    return mFirst;
-}
-
-const Node* Edge::second() const
-{
-    return mSecond;
-}
-
-const std::deque<int>& Edge::data() const
+const Edge::Indices& Edge::data() const
 {
     return mIndices;
 }
@@ -720,341 +708,12 @@ void Edge::add_voxel(int ind, int adjacency, bool back)
 }
 
 /***********************************************  UTILITIES  definition  ****************************************************/
-/******************************************************************************************
-* Skeletonize_data : this function computes a skeleton of 3D image data and store
-* its result in the skeleton data structure.
-* Implementation of : A sequential 3D thinning algorithm and its medical applications (2001)
-******************************************************************************************/
-static int skeletonize_data(const unsigned char* data, unsigned char* skeleton, const Sizes& sizes)
-{
-    if(!data)
-    {
-        std::cerr << "error, no data to skeletonize!" << std::endl;
-        return 1;
-    }
-
-    /*  copy the Black points set indices into an array */
-    /*  and create a copy of data with binary values and zero borders */
-    unsigned char *data_tmp = new unsigned char[sizes.size_enlarged];
-    for (int i = 0; i < sizes.size_enlarged; ++i)
-    {
-        data_tmp[i] = data[i];
-    }
-
-    memset(skeleton, 0, sizes.size_enlarged * sizeof(unsigned char));
-    std::list<int> black_points_set;
-
-    for(int i = 0; i < sizes.size_enlarged; ++i)
-    {
-        if(data_tmp[i])
-        {
-            black_points_set.push_back(i);
-        }
-    }
-
-    int modified;
-
-    /* Compute the 6 subiterations until no points are deleted */
-    do
-    {
-        modified = 0;
-        modified += subiter(data_tmp, black_points_set, -sizes.size_x_enlarged, sizes);       // Up
-        modified += subiter(data_tmp, black_points_set, sizes.size_x_enlarged, sizes);        // Down
-        modified += subiter(data_tmp, black_points_set, sizes.xOy_enlarged_size, sizes);      // North
-        modified += subiter(data_tmp, black_points_set, -sizes.xOy_enlarged_size, sizes);     // South
-        modified += subiter(data_tmp, black_points_set, 1, sizes);                             // East
-        modified += subiter(data_tmp, black_points_set, -1, sizes);                            // West
-
-    } while(modified > 0);
-
-    /* copy the result into the skeleton data */
-    for(std::list<int>::iterator p = black_points_set.begin(); p != black_points_set.end(); ++p)
-    {
-        skeleton[*p] = 1;
-    }
-
-    delete [] data_tmp;
-
-    return 0;
-}
-/*******************************************************************************
-*   subiter : Return the number of deleted points in the subiteration from
-*             a particular direction (6 subiterations to do).
-*   @params : The image data, the black points set,
-*             the direction, image dimensions sizes
-*******************************************************************************/
-static int subiter(unsigned char* data, std::list<int>& black_points_set, int direction, const Sizes& sizes)
-{
-    int modified = 0;
-    int np[26];
-    int nb = 0;
-
-    /* list of simple and non end points, pointers from black_points_set */
-    std::list<std::list<int>::iterator> list;
-
-    // fill the list in a first check loop.
-    for(std::list<int>::iterator p = black_points_set.begin(); p != black_points_set.end(); ++p)
-    {
-        if( is_border_point( data, direction, *p) )
-        {
-            collect_26_neighbours(*p, sizes, np);
-            nb = 0;
-            for (int i = 0; i < 26; ++i)
-            {
-                if(data[np[i]] != 0)
-                {
-                    ++nb;
-                    np[i] = 1;
-                }
-                else
-                {
-                    np[i] = 0;
-                }
-            }
-
-            if( nb > 1 )
-            {
-                if( is_simple(np) )
-                {
-                    list.push_back(p);
-                }
-            }
-        }
-    }
-
-    int value = -1;
-
-    // remove each point of the list if they remain simple and non endpoint.
-    while( value != modified )
-    {
-        value = modified;
-        for(std::list<std::list<int>::iterator>::iterator p = list.begin(); p != list.end();)
-        {
-            collect_26_neighbours(**p, sizes, np);
-            nb = 0;
-            for (int i = 0; i < 26; ++i)
-            {
-                if(data[np[i]] != 0)
-                {
-                    ++nb;
-                    np[i] = 1;
-                }
-                else
-                {
-                    np[i] = 0;
-                }
-            }
-
-            if( nb > 1 )
-            {
-                if( is_simple(np) )
-                {
-                    data[**p] = 0;
-                    black_points_set.erase(*p);
-                    p = list.erase(p);
-                    ++modified;
-                }
-                else ++p;
-            }
-            else ++p;
-        }
-    }
-
-    return modified;
-}
-
-/*******************************************************************************
-*   is_borderPoint : Return true if the point p is a border Point from one
-*                    direction.
-*   @params : The image data, the direction, the point p
-*******************************************************************************/
-static bool is_border_point(const unsigned char* data, int direction, int p)
-{
-    return !data[p + direction];
-}
-
-
-/*******************************************************************************
-*   collect_26_neighbours : save the neighbour indices in the data np.
-*   @params : the point p, image dimensions sizes, 26 neighbours
-*******************************************************************************/
-static void collect_26_neighbours( int p, const Sizes& sizes, int np[26] )
-{
-    /*  west : p - 1
-        east : p + 1
-        north : p + width*height
-        south : p - width*height
-        up : p - width
-        down : p + width
-    */
-    int vertical = sizes.size_x_enlarged;
-    int depth = sizes.xOy_enlarged_size;
-
-    int nb = 0;
-
-    /* 6-adjacent */
-    np[0] = p - vertical;                //    U
-    np[1] = p + depth;                   //     N
-    np[2] = p - 1;                       // W
-    np[3] = p + 1;                       // E
-    np[4] = p - depth;                   //     S
-    np[5] = p + vertical;                //   D
-
-    /* 18-adjacent */
-    np[6] = p - vertical + depth;        //   U N
-    np[7] = p - 1 - vertical;            // W U
-    np[8] = p + 1 - vertical;            // E U
-    np[9] = p - vertical - depth;        //   U S
-    np[10] = p - 1  + depth;             // W   N
-    np[11] = p + 1 + depth;              // E   N
-    np[12] = p - 1 - depth;              // W   S
-    np[13] = p + 1 - depth;              // E   S
-    np[14] = p + vertical + depth;       //   D N
-    np[15] = p - 1 + vertical;           // W D
-    np[16] = p + 1 + vertical;           // E D
-    np[17] = p + vertical - depth;       //   D S
-
-    /* 26-adjacent */
-    np[18] = p - 1 - vertical + depth;   // W U N
-    np[19] = p + 1 - vertical + depth;   // E U N
-    np[20] = p - 1 - vertical - depth;   // W U S
-    np[21] = p + 1 - vertical - depth;   // E U S
-    np[22] = p - 1 + vertical + depth;   // W D N
-    np[23] = p + 1 + vertical + depth;   // E D N
-    np[24] = p - 1 + vertical - depth;   // W D S
-    np[25] = p + 1 + vertical - depth;   // E D S
-}
-
-/*******************************************************************************
-*   is_simple : return true if the point is simple, i.e does not alter the
-*               topology of the picture :
-*   1. the set N26(p)∩(B\{p}) is not empty (i.e., p is not an isolated point);
-*   2. the set N26(p)∩(B\{p}) is 26–connected (in itself );
-*   3. the set (ZZ^3\B)∩ N6(p) is not empty (i.e., p is a border point); and
-*   4. the set (ZZ^3\B)∩ N6(p) is 6–connected in the set (ZZ^3\B)∩ N18(p)
-*   @params : 26 neighbour values of p
-*******************************************************************************/
-static bool is_simple(const int np[26])
-{
-    if( is_cond_2_satisfied(np) )
-    {
-        if( is_cond_4_satisfied(np ) )
-        {
-            return true;
-        }
-    }
-    return false;
-}
-
-/********************************************************************************
-* This condition check if the black points in the neighbourhood
-* of point p are 26-adjacent, to prevent from deleting p which would
-* change topology of B set. (the key of the erosion thinning process).
-* p must be a non end-point to enter this function
-*********************************************************************************/
-static bool is_cond_2_satisfied(const int np[26])
-{
-    bool visited[26] = {false};
-    int i = 0;
-    while(!np[i])
-    {
-        visited[i] = true;
-        ++i;
-    }
-
-    int res = connected26(np, i, visited);
-
-    int nb = 0;
-    for(int i = 0; i < 26; ++i)
-    {
-        if(np[i] != 0)
-        {
-            ++nb;
-        }
-    }
-
-    if(res != nb)
-    {
-        return false;
-    }
-
-    return true;
-}
-
-/********************************************************************************
-* This is a recursive fonction adding neighbors 26-adjacent in itself
-*********************************************************************************/
-static int connected26(const int np[26], int i, bool *visited)
-{
-    unsigned short nb = 1;
-    visited[i] = true;
-    unsigned short ind;
-    for(int j = INDICESS26[i]; j < INDICESS26[i+1]; ++j)
-    {
-        ind = S26[j];
-        if(!visited[ind] && np[ind])
-        {
-            nb += connected26(np, ind, visited);
-        }
-    }
-
-    return nb;
-}
-
-/********************************************************************************
-* This condition check if the white points in the 6 neighbourhood
-* of point p are 6-adjacent in 18-adjacency to keep the topology
-* of B set. (the key of the erosion thinning process)
-*********************************************************************************/
-static bool is_cond_4_satisfied(const int np[26])
-{
-    bool visited[18] = {false};
-    std::bitset<6> adjacent(0b000000);
-    int i = 0;
-    while(np[i])
-    {
-        visited[i] = true;
-        ++i;
-    }
-
-    adjacent[i] = 1;
-    connected6_18(np, i, visited, adjacent);
-
-    if(adjacent.count() != 6 - (np[0] + np[1] + np[2] + np[3] + np[4] + np[5]))
-    {
-        return false;
-    }
-
-    return true;
-}
-
-/********************************************************************************
-* This is a recursive fonction adding 6-adjacent neighbors 6-adjacent in 18 set
-********************************************************************************/
-static void connected6_18(const int np[26], int i, bool *visited, std::bitset<6>& adjacent)
-{
-    visited[i] = true;
-    unsigned short ind;
-    for(int j = INDICESS6_18[i]; j < INDICESS6_18[i+1]; ++j)
-    {
-        ind = S6_18[j];
-        if(!visited[ind] && !np[ind])
-        {
-            if(ind >= 0 && ind < 6)
-            {
-                adjacent[ind] = 1;
-            }
-            connected6_18(np, ind, visited, adjacent);
-        }
-    }
-}
-
 /**************************************************************************
 *   This function fill the data with zero borders
 **************************************************************************/
-static void bordering(const unsigned char* from, unsigned char* with_borders, const Sizes& sizes)
+static void bordering(const unsigned char* from, Bit_volume& with_borders, const Sizes& sizes)
 {
-    memset(with_borders, 0, sizes.size_enlarged * sizeof(unsigned char));
+    with_borders.clear();
 
     // xOy read order
     int depth, height, depth_enlarged, height_enlarged, ind;
@@ -1072,7 +731,7 @@ static void bordering(const unsigned char* from, unsigned char* with_borders, co
                 if(from[depth + height + k] != 0 )
                 {
                     ind = depth_enlarged + height_enlarged + k+1;
-                    with_borders[ind] = 1;
+                    with_borders.set(ind);
                 }
             }
         }
@@ -1102,146 +761,140 @@ int untransformed(int indice, const Sizes& sizes)
 *   This function finds a starting edge in the skeleton that is not yet
 visited to build the graph.
 **************************************************************************/
-int find_edge(const unsigned char *data, const Sizes& sizes, int np[26])
+int find_edge(const unsigned char *data, const unsigned char *counts, const Sizes& sizes, const Occupancy& occupancy)
 {
-    int nb;
-    int i = 0;
+    int i = occupancy.next(0);
     while (i < sizes.size_enlarged )
     {
         if(data[i] != 0)
         {
-            collect_26_neighbours(i, sizes, np);
-            nb = 0;
-            for (int j = 0; j < 26; ++j)
-            {
-                if(data[np[j]] != 0)
-                {
-                    ++nb;
-                }
-            }
-
-            if(nb == 1)
+            if(counts[i] == 1)
             {
                 return i;
             }
         }
-        ++i;
+        i = occupancy.next(i + 1);
     }
-    return i;
+    return sizes.size_enlarged;
 }
 
 /**************************************************************************
-*   This function compute a recursive depth-first search
-*   algorithm to identify and create edges and nodes on the skeleton.
+*   This function compute a depth-first search algorithm to identify
+*   and create edges and nodes on the skeleton. Each task builds the
+*   edge starting at a voxel, and the node it ends on when not yet
+*   visited, whose other edges become new tasks. The tasks are kept on
+*   a heap-allocated stack, so the call depth does not grow with the
+*   graph: pushed in reverse order and tested once popped, they are
+*   built in the order of a recursive search.
+*   The voxels are told apart by their neighbour counts: the masks of
+*   their neighbourhoods are only computed to walk to the neighbours.
 **************************************************************************/
-static void identify_voxels(int ind, const unsigned char *data, const Sizes& sizes, std::pair<Node*, Edge*>* voxel_ids)
+static void identify_voxels(int ind, const unsigned char *data, const unsigned char *counts, const Sizes& sizes, Graph_labels& labels)
 {
-    // build the edge until the destination node is encountered.
-    Edge* edge = new Edge();
-    int np[26];
-    int indice;
-    bool on_edge = true;
-    int connectivity;
-    int adjacency = 6;
+    Neighbourhood_scanner scanner(data, sizes);
+    int offsets[26];
+    collect_26_neighbours(0, sizes, offsets);
+    unsigned int mask;
 
-    do
+    std::vector<int> tasks(1, ind);
+    std::vector<int> edges;
+    std::deque<std::pair<int, int> > queue;
+
+    while (!tasks.empty())
     {
-        collect_26_neighbours(ind, sizes, np);
-        connectivity = 0;
-        for (int i = 0; i < 26; ++i)
-        {
-            if(data[np[i]] != 0)
-            {
-                ++connectivity;
-            }
-        }
+        ind = tasks.back();
+        tasks.pop_back();
 
-        if(connectivity > 2)
+        // the edge may have been built from its other end meanwhile.
+        if (labels.label(ind) > 0)
         {
-            on_edge = false;
+            continue;
         }
-        else
-        {
-            voxel_ids[ind].second = edge;
-            edge->add_voxel(ind, adjacency, true);
 
-            int i = 0;
-            while (i < 26)
-            {
-                if(data[np[i]] && !voxel_ids[np[i]].second && !voxel_ids[np[i]].first)
-                {
-                    ind = np[i];
-                    adjacency = i;
-                    break;
-                }
-                ++i;
-            }
-            if(i == 26)
+        // build the edge until the destination node is encountered.
+        const int edge_label = labels.add_edge();
+        Edge* edge = labels.edge(edge_label);
+        bool on_edge = true;
+        int adjacency = 6;
+
+        do
+        {
+            if(counts[ind] > 2)
             {
-                ind = 0;
                 on_edge = false;
             }
-        }
-    } while(on_edge);
+            else
+            {
+                mask = scanner.mask(ind);
+                labels.set(ind, edge_label);
+                edge->add_voxel(ind, adjacency, true);
 
-    // build the node if it is not yet visited and stores its connected edges.
-    if(ind)
-    {
-        Node* node = new Node();
+                int i, next;
+                while (mask)
+                {
+                    i = first_neighbour(mask);
+                    next = ind + offsets[i];
+                    if(!labels.label(next))
+                    {
+                        ind = next;
+                        adjacency = i;
+                        break;
+                    }
+                    mask &= mask - 1;
+                }
+                if(!mask)
+                {
+                    ind = 0;
+                    on_edge = false;
+                }
+            }
+        } while(on_edge);
 
-        int np[26];
-        int connectivity;
-        std::list<int> edges;
-        std::deque<int> queue;
+        // build the node if it is not yet visited and stores its connected edges.
+        if(ind)
+        {
+            const int node_label = labels.add_node();
+            Node* node = labels.node(node_label);
 
-        queue.push_back(ind);
-        voxel_ids[ind].first = node;
-        node->add_voxel(ind);
+            int neighbour;
+            edges.clear();
 
-        while(!queue.empty())
-        {
-            ind = queue.front();
-            queue.pop_front();
+            // the queued voxels are labelled with the node until they are
+            // visited, and an edge voxel then gets its former label back.
+            queue.push_back(std::make_pair(ind, labels.label(ind)));
+            labels.set(ind, node_label);
+            node->add_voxel(ind);
 
-            collect_26_neighbours(ind, sizes, np);
-            connectivity = 0;
-            for (int i = 0; i < 26; ++i)
+            while(!queue.empty())
             {
-                if(data[np[i]] != 0)
+                ind = queue.front().first;
+
+                if(counts[ind] <= 2)
                 {
-                    ++connectivity;
+                    labels.set(ind, queue.front().second);
+                    node->remove_voxel(ind);
+                    edges.push_back(ind);
                 }
-            }
-
-            if(connectivity <= 2)
-            {
-                voxel_ids[ind].first = 0;
-                node->remove_voxel(ind);
-                edges.push_back(ind);
-            }
-            else
-            {
-                for (int i = 0; i < 26; ++i)
+                else
                 {
-                    if(data[np[i]] && !voxel_ids[np[i]].first)
+                    for (mask = scanner.mask(ind); mask; mask &= mask - 1)
                     {
-                        queue.push_back(np[i]);
-                        voxel_ids[np[i]].first = node;
-                        node->add_voxel(np[i]);
+                        neighbour = ind + offsets[first_neighbour(mask)];
+                        if(labels.label(neighbour) >= 0)
+                        {
+                            queue.push_back(std::make_pair(neighbour, labels.label(neighbour)));
+                            labels.set(neighbour, node_label);
+                            node->add_voxel(neighbour);
+                        }
                     }
                 }
+                queue.pop_front();
             }
-        }
 
-        node->set_connectivity(edges.size());
+            node->set_connectivity(edges.size());
 
-        // build edges that starts from the node and are not already built in depth-first search.
-        for (std::list<int>::iterator it = edges.begin(); it != edges.end(); ++it)
-        {
-            if (!voxel_ids[*it].second)
-            {
-                identify_voxels(*it, data, sizes, voxel_ids);
-            }
+            // build edges that starts from the node and are not already built in depth-first search.
+            tasks.insert(tasks.end(), edges.rbegin(), edges.rend());
         }
     }
 }
@@ -1252,31 +905,28 @@ static void identify_voxels(int ind, const unsigned char *data, const Sizes& siz
 * 1: check that node voxel deletion doesn't disconnect its node voxel neighbours
 * 2: check if the edges connected to the node voxel are still connected to the node.
 **************************************************************************/
-static bool is_node_refinable(int ind, const Edge* edge, const Sizes& sizes, std::pair<Node*, Edge*>* voxel_ids)
+static bool is_node_refinable(int ind, int edge, const Sizes& sizes, const Graph_labels& labels)
 {
     int np[26];
-    std::list<Edge*> edges;
+    unsigned int mask = 0;
+    std::list<int> edges;
     std::list<int> node_voxels;
-int nttt = 0;
+
     // check the neighbours of the node voxels
     collect_26_neighbours(ind, sizes, np);
     for (int i = 0; i < 26; ++i)
     {
         // temporarily stores the edges connected to that node voxel.
-        if (voxel_ids[np[i]].second && voxel_ids[np[i]].second != edge)
+        if (labels.label(np[i]) > 0 && labels.label(np[i]) != edge)
         {
-            edges.push_back(voxel_ids[np[i]].second);
+            edges.push_back(labels.label(np[i]));
         }
 
         // temporarily stores the node voxels 26-adjacent to that node voxel.
-        if (voxel_ids[np[i]].first)
+        if (labels.label(np[i]) < 0)
         {
             node_voxels.push_back(np[i]);
-            np[i] = 1;
-        }
-        else
-        {
-            np[i] = 0;
+            mask |= 1u << i;
         }
     }
 
@@ -1284,7 +934,7 @@ int nttt = 0;
     if(!node_voxels.empty() && !edges.empty())
     {
         // condition 1.
-        if (is_cond_2_satisfied(np))
+        if (is_26_connected(mask))
         {
             // condition 2.
             for (std::list<int>::iterator it = node_voxels.begin(); it != node_voxels.end() && !edges.empty(); ++it)
@@ -1292,9 +942,9 @@ int nttt = 0;
                 collect_26_neighbours(*it, sizes, np);
                 for (int i = 0; i < 26 && !edges.empty(); ++i)
                 {
-                    for (std::list<Edge*>::iterator edge_it = edges.begin(); edge_it != edges.end();)
+                    for (std::list<int>::iterator edge_it = edges.begin(); edge_it != edges.end();)
                     {
-                        if (voxel_ids[np[i]].second == *edge_it)
+                        if (labels.label(np[i]) == *edge_it)
                         {
                             edge_it = edges.erase(edge_it);
                         }
@@ -1317,38 +967,37 @@ int nttt = 0;
 *   This function try to refine the nodes to their minimum
 *   of voxels.
 **************************************************************************/
-static void refine_nodes(const Sizes& sizes, std::pair<Node*, Edge*>* voxel_ids)
+static void refine_nodes(const Sizes& sizes, Graph_labels& labels, const Occupancy& occupancy)
 {
-    bool* visited_tmp = new bool[sizes.size_enlarged];
-    memset(visited_tmp, 0, sizes.size_enlarged * sizeof(bool));
+    Bit_volume visited_tmp(sizes.size_enlarged);
     int np[26];
-    int ind;
+    int ind, edge;
     int front, back;
 
-    for (int i = 0; i < sizes.size_enlarged; ++i)
+    for (int i = occupancy.next(0); i < sizes.size_enlarged; i = occupancy.next(i + 1))
     {
         // for each edges non visited yet
-        if(voxel_ids[i].second)
+        edge = labels.label(i);
+        if(edge > 0)
         {
             // find its start and end voxel and for both, refine the connected node voxel
-            front = voxel_ids[i].second->data().front();
-            back = voxel_ids[i].second->data().back();
+            front = labels.edge(edge)->data().front();
+            back = labels.edge(edge)->data().back();
 
-            if(!visited_tmp[front])
+            if(!visited_tmp.test(front))
             {
                 collect_26_neighbours(front, sizes, np);
                 for (int j = 0; j < 26; ++j)
                 {
-                    if(voxel_ids[np[j]].first)
+                    if(labels.label(np[j]) < 0)
                     {
                         ind = np[j];
                         // refine the front node if it is possible.
-                        if(is_node_refinable(ind, voxel_ids[i].second, sizes, voxel_ids))
+                        if(is_node_refinable(ind, edge, sizes, labels))
                         {
-                            voxel_ids[ind].second = voxel_ids[i].second;
-                            voxel_ids[ind].second->add_voxel(ind, j, false);
-                            voxel_ids[ind].first->remove_voxel(ind);
-                            voxel_ids[ind].first = 0;
+                            labels.edge(edge)->add_voxel(ind, j, false);
+                            labels.node_at(ind)->remove_voxel(ind);
+                            labels.set(ind, edge);
                             break;
                         }
                     }
@@ -1357,86 +1006,79 @@ static void refine_nodes(const Sizes& sizes, std::pair<Node*, Edge*>* voxel_ids)
                 collect_26_neighbours(back, sizes, np);
                 for (int j = 0; j < 26; ++j)
                 {
-                    if(voxel_ids[np[j]].first)
+                    if(labels.label(np[j]) < 0)
                     {
                         ind = np[j];
                         // refine the back node if it is possible.
-                        if(is_node_refinable(ind, voxel_ids[i].second, sizes, voxel_ids))
+                        if(is_node_refinable(ind, edge, sizes, labels))
                         {
-                            voxel_ids[ind].second = voxel_ids[i].second;
-                            voxel_ids[ind].second->add_voxel(ind, j, true);
-                            voxel_ids[ind].first->remove_voxel(ind);
-                            voxel_ids[ind].first = 0;
+                            labels.edge(edge)->add_voxel(ind, j, true);
+                            labels.node_at(ind)->remove_voxel(ind);
+                            labels.set(ind, edge);
                             break;
                         }
                     }
                 }
 
-                front = voxel_ids[i].second->data().front();
-                visited_tmp[front] = true;
+                front = labels.edge(edge)->data().front();
+                visited_tmp.set(front);
             }
         }
     }
 
-    delete [] visited_tmp;
 }
 
 /**************************************************************************
 *   This function removes branches that are smaller than a
 *   given threshold.
 **************************************************************************/
-static void remove_small_branches(const Sizes& sizes, std::pair<Node*, Edge*>* voxel_ids)
+static void remove_small_branches(const Sizes& sizes, Graph_labels& labels, const Occupancy& occupancy)
 {
-    bool* visited_tmp = new bool[sizes.size_enlarged];
-    memset(visited_tmp, 0, sizes.size_enlarged * sizeof(bool));
-    int np[26];
+    Bit_volume visited_tmp(sizes.size_enlarged);
     Edge* edge;
-    Node* node_front;
-    Node* node_back;
+    int node_front, node_back;
     int ind, back;
 
-    for (int i = 0; i < sizes.size_enlarged; ++i)
+    for (int i = occupancy.next(0); i < sizes.size_enlarged; i = occupancy.next(i + 1))
     {
         node_front = 0;
         node_back = 0;
 
         // for each edges non visited yet
-        if(voxel_ids[i].second)
+        if(labels.label(i) > 0)
         {
-            edge = voxel_ids[i].second;
+            edge = labels.edge_at(i);
             back = edge->data().back();
 
-            if (!visited_tmp[back])
+            if (!visited_tmp.test(back))
             {
                 // if the edge is a branch
-                if (is_branch(edge, node_back, node_front, sizes, voxel_ids))
+                if (is_branch(edge, node_back, node_front, sizes, labels))
                 {
                     // if the branch is too small, remove it
                     if (edge->length() < BRANCH_THRESHOLD)
                     {
+                        labels.remove(labels.label(i));
                         for (int j = 0; j < edge->data().size(); ++j)
                         {
                             ind = edge->data()[j];
-                            voxel_ids[ind].second = 0;
+                            labels.set(ind, 0);
                         }
-
-                        delete edge;
                     }
                 }
 
-                visited_tmp[back] = true;
+                visited_tmp.set(back);
             }
         }
     }
 
-    delete [] visited_tmp;
 }
 
 /**************************************************************************
 *   This function check if the edge is a branch, and update its back
 *   and front nodes.
 **************************************************************************/
-static bool is_branch(const Edge* edge, Node*& node_back, Node*& node_front, const Sizes& sizes, const std::pair<Node*, Edge*>* voxel_ids)
+static bool is_branch(const Edge* edge, int& node_back, int& node_front, const Sizes& sizes, const Graph_labels& labels)
 {
     int np[26];
     int edge_junctions = 0;
@@ -1445,10 +1087,10 @@ static bool is_branch(const Edge* edge, Node*& node_back, Node*& node_front, con
     collect_26_neighbours(edge->data().back(), sizes, np);
     for (int j = 0; j < 26; ++j)
     {
-        if (voxel_ids[np[j]].first)
+        if (labels.label(np[j]) < 0)
         {
             edge_junctions += 1;
-            node_back = voxel_ids[np[j]].first;
+            node_back = labels.label(np[j]);
             break;
         }
     }
@@ -1457,10 +1099,10 @@ static bool is_branch(const Edge* edge, Node*& node_back, Node*& node_front, con
     collect_26_neighbours(edge->data().front(), sizes, np);
     for (int j = 0; j < 26; ++j)
     {
-        if (voxel_ids[np[j]].first && voxel_ids[np[j]].first != node_back)
+        if (labels.label(np[j]) < 0 && labels.label(np[j]) != node_back)
         {
             edge_junctions += 1;
-            node_front = voxel_ids[np[j]].first;
+            node_front = labels.label(np[j]);
             break;
         }
     }
@@ -1479,66 +1121,63 @@ static bool is_branch(const Edge* edge, Node*& node_back, Node*& node_front, con
 *   threshold. (the edge and the back node both become part of the unique
 *   front node)
 **************************************************************************/
-static void fusion_nodes(const Sizes& sizes, std::pair<Node*, Edge*>* voxel_ids)
+static void fusion_nodes(const Sizes& sizes, Graph_labels& labels, const Occupancy& occupancy)
 {
-    bool* visited_tmp = new bool[sizes.size_enlarged];
-    memset(visited_tmp, 0, sizes.size_enlarged * sizeof(bool));
-    std::deque<int> queue;
-    int np[26];
+    Bit_volume visited_tmp(sizes.size_enlarged);
     Edge* edge;
-    Node* node_front;
-    Node* node_back;
+    Node* front;
+    Node* fusionned;
+    int node_front, node_back;
     int ind, back;
 
-    for (int i = 0; i < sizes.size_enlarged; ++i)
+    for (int i = occupancy.next(0); i < sizes.size_enlarged; i = occupancy.next(i + 1))
     {
         node_front = 0;
         node_back = 0;
 
         // for each edges non visited yet
-        if(voxel_ids[i].second)
+        if(labels.label(i) > 0)
         {
-            edge = voxel_ids[i].second;
+            edge = labels.edge_at(i);
             back = edge->data().back();
 
-            if (!visited_tmp[back])
+            if (!visited_tmp.test(back))
             {
                 // if the edge is not a branch
-                if (!is_branch(edge, node_back, node_front, sizes, voxel_ids))
+                if (!is_branch(edge, node_back, node_front, sizes, labels))
                 {
                     // if the edge is too small, replace it by the front node
                     if (edge->length() < EDGE_THRESHOLD)
                     {
+                        front = labels.node(node_front);
+                        labels.remove(labels.label(i));
                         for (int j = 0; j < edge->data().size(); ++j)
                         {
                             ind = edge->data()[j];
-                            voxel_ids[ind].second = 0;
-                            voxel_ids[ind].first = node_front;
-                            node_front->add_voxel(ind);
+                            labels.set(ind, node_front);
+                            front->add_voxel(ind);
                         }
 
-                        delete edge;
-
                         // Fusion the nodes that were connected to the edge: all back node voxels becomes front node.
-                        for (std::list<int>::const_iterator it = node_back->positions().begin(); it != node_back->positions().end(); ++it)
+                        fusionned = labels.node(node_back);
+                        for (Node::Positions::const_iterator it = fusionned->positions().begin(); it != fusionned->positions().end(); ++it)
                         {
-                            node_front->add_voxel(*it);
-                            voxel_ids[*it].first = node_front;
+                            front->add_voxel(*it);
+                            labels.set(*it, node_front);
                         }
 
                         // update the fusionned node connectivity.
-                        node_front->set_connectivity(node_back->connectivity() + node_front->connectivity() - 2);
+                        front->set_connectivity(fusionned->connectivity() + front->connectivity() - 2);
 
-                        delete node_back;
+                        labels.remove(node_back);
                     }
                 }
 
-                visited_tmp[back] = true;
+                visited_tmp.set(back);
             }
         }
     }
 
-    delete [] visited_tmp;
 }
 
 } // end of namespace Trabecula
\ No newline at end of file